@@ -0,0 +1,647 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#include "compressedfile.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QStringDecoder>
+#else
+#include <QTextCodec>
+#endif
+
+#ifdef LIBREPAD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LIBREPAD_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef LIBREPAD_HAVE_LZMA
+#include <lzma.h>
+#endif
+
+namespace {
+
+const qint64 ReadChunkSize = 256 * 1024;
+const int OutputChunkSize  = 256 * 1024;
+const int QueueCapacity    = 4;
+
+// producer/consumer queue between two pipeline stages
+template<typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue()
+        : m_closed(false)
+        , m_aborted(false)
+    {
+    }
+
+    bool push(const T &item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_queue.size() >= QueueCapacity && !m_aborted)
+        {
+            m_notFull.wait(&m_mutex);
+        }
+        if (m_aborted)
+        {
+            return false;
+        }
+        m_queue.enqueue(item);
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // false once the queue is drained and closed, or aborted
+    bool pop(T *item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_queue.isEmpty() && !m_closed && !m_aborted)
+        {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_aborted || m_queue.isEmpty())
+        {
+            return false;
+        }
+        *item = m_queue.dequeue();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    bool tryPop(T *item)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_aborted || m_queue.isEmpty())
+        {
+            return false;
+        }
+        *item = m_queue.dequeue();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    bool atEnd()
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_aborted || (m_closed && m_queue.isEmpty());
+    }
+
+    bool isAborted()
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_aborted;
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+    }
+
+    void abort()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_aborted = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<T> m_queue;
+    bool m_closed;
+    bool m_aborted;
+};
+
+} // namespace
+
+struct DecompressPipeline::Stages
+{
+    BoundedQueue<QByteArray> compressed;
+    BoundedQueue<QByteArray> decompressed;
+    BoundedQueue<QString> text;
+    QAtomicInt failed;
+};
+
+CompressedFile::Format CompressedFile::format(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return formatForName(fileName);
+    }
+    const QByteArray magic = file.read(6);
+    file.close();
+
+    if (magic.startsWith("\x1f\x8b"))
+    {
+        return Gzip;
+    }
+    if (magic.startsWith("\x28\xb5\x2f\xfd"))
+    {
+        return Zstd;
+    }
+    if (magic == QByteArray("\xfd\x37\x7a\x58\x5a\x00", 6))
+    {
+        return Xz;
+    }
+    return None;
+}
+
+CompressedFile::Format CompressedFile::formatForName(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "gz")
+    {
+        return Gzip;
+    }
+    if (suffix == "zst")
+    {
+        return Zstd;
+    }
+    if (suffix == "xz")
+    {
+        return Xz;
+    }
+    return None;
+}
+
+bool CompressedFile::isSupported(Format format)
+{
+    switch (format)
+    {
+#ifdef LIBREPAD_HAVE_ZLIB
+    case Gzip:
+        return true;
+#endif
+#ifdef LIBREPAD_HAVE_ZSTD
+    case Zstd:
+        return true;
+#endif
+#ifdef LIBREPAD_HAVE_LZMA
+    case Xz:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool CompressedFile::write(Format format, const QByteArray &data, QIODevice *device, QString *errorString)
+{
+    if (format == None)
+    {
+        if (device->write(data) != data.size())
+        {
+            *errorString = device->errorString();
+            return false;
+        }
+        return true;
+    }
+
+    if (!isSupported(format))
+    {
+        *errorString = QObject::tr("compression format not supported by this build");
+        return false;
+    }
+
+    // the input is fed in slices and every filled buffer written out
+    QByteArray output(OutputChunkSize, Qt::Uninitialized);
+    auto flush = [&](qint64 size) {
+        if (size > 0 && device->write(output.constData(), size) != size)
+        {
+            *errorString = device->errorString();
+            return false;
+        }
+        return true;
+    };
+
+#ifdef LIBREPAD_HAVE_ZLIB
+    if (format == Gzip)
+    {
+        z_stream stream = {};
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            *errorString = QObject::tr("cannot initialize gzip");
+            return false;
+        }
+        qint64 pos = 0;
+        int ret;
+        do
+        {
+            const qint64 slice = qMin<qint64>(ReadChunkSize, data.size() - pos);
+            stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData() + pos));
+            stream.avail_in = uInt(slice);
+            pos += slice;
+            const int flushMode = pos >= data.size() ? Z_FINISH : Z_NO_FLUSH;
+            do
+            {
+                stream.next_out  = reinterpret_cast<Bytef *>(output.data());
+                stream.avail_out = uInt(output.size());
+                ret = deflate(&stream, flushMode);
+                if (!flush(output.size() - stream.avail_out))
+                {
+                    deflateEnd(&stream);
+                    return false;
+                }
+            } while (stream.avail_out == 0);
+        } while (ret != Z_STREAM_END);
+        deflateEnd(&stream);
+        return true;
+    }
+#endif
+
+#ifdef LIBREPAD_HAVE_ZSTD
+    if (format == Zstd)
+    {
+        ZSTD_CCtx *stream = ZSTD_createCCtx();
+        qint64 pos = 0;
+        size_t remaining;
+        do
+        {
+            const qint64 slice = qMin<qint64>(ReadChunkSize, data.size() - pos);
+            ZSTD_inBuffer in = { data.constData() + pos, size_t(slice), 0 };
+            pos += slice;
+            const ZSTD_EndDirective mode = pos >= data.size() ? ZSTD_e_end : ZSTD_e_continue;
+            do
+            {
+                ZSTD_outBuffer out = { output.data(), size_t(output.size()), 0 };
+                remaining = ZSTD_compressStream2(stream, &out, &in, mode);
+                if (ZSTD_isError(remaining))
+                {
+                    *errorString = QString::fromLatin1(ZSTD_getErrorName(remaining));
+                    ZSTD_freeCCtx(stream);
+                    return false;
+                }
+                if (!flush(qint64(out.pos)))
+                {
+                    ZSTD_freeCCtx(stream);
+                    return false;
+                }
+            } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+        } while (pos < data.size());
+        ZSTD_freeCCtx(stream);
+        return true;
+    }
+#endif
+
+#ifdef LIBREPAD_HAVE_LZMA
+    if (format == Xz)
+    {
+        lzma_stream stream = LZMA_STREAM_INIT;
+        if (lzma_easy_encoder(&stream, 6, LZMA_CHECK_CRC64) != LZMA_OK)
+        {
+            *errorString = QObject::tr("cannot initialize xz");
+            return false;
+        }
+        qint64 pos = 0;
+        lzma_ret ret;
+        do
+        {
+            const qint64 slice = qMin<qint64>(ReadChunkSize, data.size() - pos);
+            stream.next_in  = reinterpret_cast<const uint8_t *>(data.constData() + pos);
+            stream.avail_in = size_t(slice);
+            pos += slice;
+            const lzma_action action = pos >= data.size() ? LZMA_FINISH : LZMA_RUN;
+            do
+            {
+                stream.next_out  = reinterpret_cast<uint8_t *>(output.data());
+                stream.avail_out = size_t(output.size());
+                ret = lzma_code(&stream, action);
+                if (ret != LZMA_OK && ret != LZMA_STREAM_END)
+                {
+                    *errorString = QObject::tr("xz compression failed");
+                    lzma_end(&stream);
+                    return false;
+                }
+                if (!flush(output.size() - qint64(stream.avail_out)))
+                {
+                    lzma_end(&stream);
+                    return false;
+                }
+            } while (stream.avail_out == 0);
+        } while (ret != LZMA_STREAM_END);
+        lzma_end(&stream);
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+DecompressPipeline::DecompressPipeline(const QString &fileName, CompressedFile::Format format, QObject *parent)
+    : QObject(parent)
+    , m_fileName(fileName)
+    , m_format(format)
+    , m_stages(new Stages)
+    , m_reader(nullptr)
+    , m_decompressor(nullptr)
+    , m_decoder(nullptr)
+{
+}
+
+DecompressPipeline::~DecompressPipeline()
+{
+    m_stages->compressed.abort();
+    m_stages->decompressed.abort();
+    m_stages->text.abort();
+
+    for (QThread *thread : { m_reader, m_decompressor, m_decoder })
+    {
+        if (thread != nullptr)
+        {
+            thread->wait();
+            delete thread;
+        }
+    }
+}
+
+void DecompressPipeline::start()
+{
+    m_reader       = QThread::create([this]() { read(); });
+    m_decompressor = QThread::create([this]() { decompress(); });
+    m_decoder      = QThread::create([this]() { decode(); });
+    m_reader->start();
+    m_decompressor->start();
+    m_decoder->start();
+}
+
+bool DecompressPipeline::takeText(QString *text)
+{
+    return m_stages->text.tryPop(text);
+}
+
+bool DecompressPipeline::atEnd() const
+{
+    return m_stages->text.atEnd();
+}
+
+bool DecompressPipeline::hasFailed() const
+{
+    return m_stages->failed.loadAcquire() != 0;
+}
+
+void DecompressPipeline::fail(const QString &errorString)
+{
+    // set before the queues end, so it is seen together with atEnd()
+    m_stages->failed.storeRelease(1);
+    m_stages->compressed.abort();
+    m_stages->decompressed.abort();
+    m_stages->text.abort();
+    emit failed(errorString);
+}
+
+void DecompressPipeline::read()
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        fail(file.errorString());
+        return;
+    }
+
+    while (!file.atEnd())
+    {
+        const QByteArray chunk = file.read(ReadChunkSize);
+        if (chunk.isEmpty())
+        {
+            fail(file.errorString());
+            return;
+        }
+        if (!m_stages->compressed.push(chunk))
+        {
+            return;
+        }
+    }
+    m_stages->compressed.close();
+}
+
+void DecompressPipeline::decompress()
+{
+    QByteArray input;
+    QByteArray output(OutputChunkSize, Qt::Uninitialized);
+    BoundedQueue<QByteArray> &in  = m_stages->compressed;
+    BoundedQueue<QByteArray> &out = m_stages->decompressed;
+
+    switch (m_format)
+    {
+#ifdef LIBREPAD_HAVE_ZLIB
+    case CompressedFile::Gzip:
+    {
+        z_stream stream = {};
+        // 32: detect gzip or zlib header
+        if (inflateInit2(&stream, 15 + 32) != Z_OK)
+        {
+            fail(tr("cannot initialize gzip"));
+            return;
+        }
+        bool ended = false;
+        while (in.pop(&input))
+        {
+            stream.next_in  = reinterpret_cast<Bytef *>(input.data());
+            stream.avail_in = uInt(input.size());
+            do
+            {
+                stream.next_out  = reinterpret_cast<Bytef *>(output.data());
+                stream.avail_out = uInt(output.size());
+                const int ret = inflate(&stream, Z_NO_FLUSH);
+                if (ret == Z_STREAM_END)
+                {
+                    // concatenated members, as written by rotating loggers
+                    inflateReset(&stream);
+                    ended = true;
+                }
+                else if (ret == Z_OK)
+                {
+                    ended = false;
+                }
+                else if (ret != Z_OK && ret != Z_BUF_ERROR)
+                {
+                    inflateEnd(&stream);
+                    fail(tr("corrupt gzip data"));
+                    return;
+                }
+                const int produced = output.size() - int(stream.avail_out);
+                if (produced > 0 && !out.push(output.left(produced)))
+                {
+                    inflateEnd(&stream);
+                    return;
+                }
+            } while (stream.avail_in > 0 || stream.avail_out == 0);
+        }
+        inflateEnd(&stream);
+        if (!ended && !in.isAborted())
+        {
+            fail(tr("truncated gzip data"));
+            return;
+        }
+        break;
+    }
+#endif
+#ifdef LIBREPAD_HAVE_ZSTD
+    case CompressedFile::Zstd:
+    {
+        ZSTD_DStream *stream = ZSTD_createDStream();
+        ZSTD_initDStream(stream);
+        // 0 once a frame is complete and flushed
+        size_t remaining = 1;
+        while (in.pop(&input))
+        {
+            ZSTD_inBuffer inBuffer = { input.constData(), size_t(input.size()), 0 };
+            ZSTD_outBuffer outBuffer;
+            do
+            {
+                outBuffer = { output.data(), size_t(output.size()), 0 };
+                const size_t consumed = inBuffer.pos;
+                const size_t ret = ZSTD_decompressStream(stream, &outBuffer, &inBuffer);
+                if (ZSTD_isError(ret))
+                {
+                    ZSTD_freeDStream(stream);
+                    fail(QString::fromLatin1(ZSTD_getErrorName(ret)));
+                    return;
+                }
+                if (inBuffer.pos != consumed || outBuffer.pos > 0)
+                {
+                    remaining = ret;
+                }
+                if (outBuffer.pos > 0 && !out.push(output.left(int(outBuffer.pos))))
+                {
+                    ZSTD_freeDStream(stream);
+                    return;
+                }
+            } while (inBuffer.pos < inBuffer.size || outBuffer.pos == outBuffer.size);
+        }
+        ZSTD_freeDStream(stream);
+        if (remaining != 0 && !in.isAborted())
+        {
+            fail(tr("truncated zstd data"));
+            return;
+        }
+        break;
+    }
+#endif
+#ifdef LIBREPAD_HAVE_LZMA
+    case CompressedFile::Xz:
+    {
+        lzma_stream stream = LZMA_STREAM_INIT;
+        if (lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK)
+        {
+            fail(tr("cannot initialize xz"));
+            return;
+        }
+        lzma_ret ret = LZMA_OK;
+        bool finishing = false;
+        while (ret != LZMA_STREAM_END)
+        {
+            if (!finishing && stream.avail_in == 0)
+            {
+                if (in.pop(&input))
+                {
+                    stream.next_in  = reinterpret_cast<const uint8_t *>(input.constData());
+                    stream.avail_in = size_t(input.size());
+                }
+                else if (in.isAborted())
+                {
+                    lzma_end(&stream);
+                    return;
+                }
+                else
+                {
+                    finishing = true;
+                }
+            }
+
+            stream.next_out  = reinterpret_cast<uint8_t *>(output.data());
+            stream.avail_out = size_t(output.size());
+            ret = lzma_code(&stream, finishing ? LZMA_FINISH : LZMA_RUN);
+            if (ret != LZMA_OK && ret != LZMA_STREAM_END)
+            {
+                lzma_end(&stream);
+                fail(tr("corrupt xz data"));
+                return;
+            }
+            const int produced = output.size() - int(stream.avail_out);
+            if (produced > 0 && !out.push(output.left(produced)))
+            {
+                lzma_end(&stream);
+                return;
+            }
+        }
+        lzma_end(&stream);
+        break;
+    }
+#endif
+    default:
+        fail(tr("compression format not supported by this build"));
+        return;
+    }
+
+    if (!in.isAborted())
+    {
+        out.close();
+    }
+}
+
+void DecompressPipeline::decode()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QStringDecoder decoder(QStringDecoder::Utf8);
+#else
+    QScopedPointer<QTextDecoder> decoder(QTextCodec::codecForName("UTF-8")->makeDecoder());
+#endif
+
+    // a '\r' at the end of a chunk may belong to a "\r\n" in the next one
+    bool pendingReturn = false;
+    QByteArray bytes;
+    while (m_stages->decompressed.pop(&bytes))
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        QString text = decoder.decode(bytes);
+#else
+        QString text = decoder->toUnicode(bytes);
+#endif
+        if (pendingReturn)
+        {
+            text.prepend('\r');
+        }
+        pendingReturn = text.endsWith('\r');
+        if (pendingReturn)
+        {
+            text.chop(1);
+        }
+        text.replace("\r\n", "\n");
+
+        if (!text.isEmpty())
+        {
+            if (!m_stages->text.push(text))
+            {
+                return;
+            }
+            emit textAvailable();
+        }
+    }
+    if (m_stages->decompressed.isAborted())
+    {
+        return;
+    }
+
+    if (pendingReturn)
+    {
+        m_stages->text.push(QString("\r"));
+    }
+    m_stages->text.close();
+    emit finished();
+}
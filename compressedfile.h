@@ -0,0 +1,73 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+class QIODevice;
+class QThread;
+
+class CompressedFile
+{
+public:
+    enum Format
+    {
+        None,
+        Gzip,
+        Zstd,
+        Xz
+    };
+
+    static Format format(const QString &fileName);
+    static Format formatForName(const QString &fileName);
+    static bool isSupported(Format format);
+
+    static bool write(Format format, const QByteArray &data, QIODevice *device, QString *errorString);
+};
+
+/*
+ * Streams a compressed file into text.
+ *
+ * Reading, decompressing and decoding run on their own threads and are
+ * connected by small bounded queues, so they overlap and memory use does
+ * not depend on the file size. The decoded text is fetched with
+ * takeText() whenever textAvailable() is emitted.
+ */
+class DecompressPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    DecompressPipeline(const QString &fileName, CompressedFile::Format format, QObject *parent = nullptr);
+    ~DecompressPipeline();
+
+    void start();
+    bool takeText(QString *text);
+    bool atEnd() const;
+    bool hasFailed() const;
+
+signals:
+    void textAvailable();
+    void finished();
+    void failed(const QString &errorString);
+
+private:
+    struct Stages;
+
+    QString m_fileName;
+    CompressedFile::Format m_format;
+    QScopedPointer<Stages> m_stages;
+    QThread *m_reader;
+    QThread *m_decompressor;
+    QThread *m_decoder;
+
+    void read();
+    void decompress();
+    void decode();
+    void fail(const QString &errorString);
+};
+
+#endif   // COMPRESSEDFILE_H
@@ -0,0 +1,253 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#include "foldrangetree.h"
+
+#include <QtGlobal>
+
+FoldRangeTree::FoldRangeTree()
+    : m_root(nullptr)
+    , m_seed(2463534242u)
+{
+}
+
+FoldRangeTree::~FoldRangeTree()
+{
+    destroy(m_root);
+}
+
+void FoldRangeTree::clear()
+{
+    destroy(m_root);
+    m_root = nullptr;
+}
+
+void FoldRangeTree::insert(int start, int end)
+{
+    remove(start);
+
+    Node *node     = new Node;
+    node->start    = start;
+    node->end      = end;
+    node->maxEnd   = end;
+    node->offset   = 0;
+    node->priority = nextPriority();
+    node->left     = nullptr;
+    node->right    = nullptr;
+
+    Node *left;
+    Node *right;
+    split(m_root, start, left, right);
+    m_root = merge(merge(left, node), right);
+}
+
+bool FoldRangeTree::remove(int start)
+{
+    Node *left;
+    Node *middle;
+    Node *right;
+    split(m_root, start, left, right);
+    split(right, start + 1, middle, right);
+
+    const bool found = middle != nullptr;
+    destroy(middle);
+    m_root = merge(left, right);
+    return found;
+}
+
+bool FoldRangeTree::find(int start, Range *range) const
+{
+    const Node *node = m_root;
+    int offset = 0;
+    while (node != nullptr)
+    {
+        const int nodeStart = node->start + offset;
+        if (nodeStart == start)
+        {
+            range->start = nodeStart;
+            range->end   = node->end + offset;
+            return true;
+        }
+        offset += node->offset;
+        node = start < nodeStart ? node->left : node->right;
+    }
+    return false;
+}
+
+QVector<FoldRangeTree::Range> FoldRangeTree::overlapping(int first, int last) const
+{
+    QVector<Range> ranges;
+    collect(m_root, 0, first, last, ranges);
+    return ranges;
+}
+
+QVector<FoldRangeTree::Range> FoldRangeTree::takeOverlapping(int first, int last)
+{
+    const QVector<Range> ranges = overlapping(first, last);
+    for (const Range &range : ranges)
+    {
+        remove(range.start);
+    }
+    return ranges;
+}
+
+void FoldRangeTree::shift(int from, int delta)
+{
+    if (delta == 0)
+    {
+        return;
+    }
+
+    // ranges starting behind the edit move as a whole, the others only
+    // stretch when they reach over it
+    Node *left;
+    Node *right;
+    split(m_root, from, left, right);
+    move(right, delta);
+    shiftEnds(left, from, delta);
+    m_root = merge(left, right);
+}
+
+quint32 FoldRangeTree::nextPriority()
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+void FoldRangeTree::push(Node *node)
+{
+    if (node->offset != 0)
+    {
+        move(node->left, node->offset);
+        move(node->right, node->offset);
+        node->offset = 0;
+    }
+}
+
+void FoldRangeTree::update(Node *node)
+{
+    node->maxEnd = node->end;
+    if (node->left != nullptr)
+    {
+        node->maxEnd = qMax(node->maxEnd, node->left->maxEnd);
+    }
+    if (node->right != nullptr)
+    {
+        node->maxEnd = qMax(node->maxEnd, node->right->maxEnd);
+    }
+}
+
+void FoldRangeTree::move(Node *node, int delta)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    node->start  += delta;
+    node->end    += delta;
+    node->maxEnd += delta;
+    node->offset += delta;
+}
+
+void FoldRangeTree::split(Node *node, int start, Node *&left, Node *&right)
+{
+    if (node == nullptr)
+    {
+        left  = nullptr;
+        right = nullptr;
+        return;
+    }
+
+    push(node);
+    if (node->start < start)
+    {
+        split(node->right, start, node->right, right);
+        left = node;
+    }
+    else
+    {
+        split(node->left, start, left, node->left);
+        right = node;
+    }
+    update(node);
+}
+
+FoldRangeTree::Node *FoldRangeTree::merge(Node *left, Node *right)
+{
+    if (left == nullptr)
+    {
+        return right;
+    }
+    if (right == nullptr)
+    {
+        return left;
+    }
+
+    if (left->priority > right->priority)
+    {
+        push(left);
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    }
+
+    push(right);
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+}
+
+void FoldRangeTree::destroy(Node *node)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    destroy(node->left);
+    destroy(node->right);
+    delete node;
+}
+
+void FoldRangeTree::collect(const Node *node, int offset, int first, int last, QVector<Range> &ranges)
+{
+    if (node == nullptr || node->maxEnd + offset < first)
+    {
+        return;
+    }
+
+    const int childOffset = offset + node->offset;
+    collect(node->left, childOffset, first, last, ranges);
+
+    const int start = node->start + offset;
+    if (start > last)
+    {
+        return;
+    }
+    if (node->end + offset >= first)
+    {
+        Range range;
+        range.start = start;
+        range.end   = node->end + offset;
+        ranges.append(range);
+    }
+    collect(node->right, childOffset, first, last, ranges);
+}
+
+void FoldRangeTree::shiftEnds(Node *node, int from, int delta)
+{
+    if (node == nullptr || node->maxEnd < from)
+    {
+        return;
+    }
+
+    push(node);
+    if (node->end >= from)
+    {
+        node->end += delta;
+    }
+    shiftEnds(node->left, from, delta);
+    shiftEnds(node->right, from, delta);
+    update(node);
+}
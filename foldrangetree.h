@@ -0,0 +1,66 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#ifndef FOLDRANGETREE_H
+#define FOLDRANGETREE_H
+
+#include <QVector>
+
+/*
+ * Interval tree of folded block ranges.
+ *
+ * A treap ordered by start block and augmented with the largest end of
+ * each subtree. Block numbers after an edit are moved with a lazy offset,
+ * so an edit costs O(log n) plus the ranges it touches.
+ */
+class FoldRangeTree
+{
+public:
+    struct Range
+    {
+        int start;
+        int end;
+    };
+
+    FoldRangeTree();
+    ~FoldRangeTree();
+
+    bool isEmpty() const { return m_root == nullptr; }
+    void clear();
+
+    void insert(int start, int end);
+    bool remove(int start);
+    bool find(int start, Range *range) const;
+
+    QVector<Range> overlapping(int first, int last) const;
+    QVector<Range> takeOverlapping(int first, int last);
+    void shift(int from, int delta);
+
+private:
+    struct Node
+    {
+        int start;
+        int end;
+        int maxEnd;
+        int offset;
+        quint32 priority;
+        Node *left;
+        Node *right;
+    };
+
+    Node *m_root;
+    quint32 m_seed;
+
+    quint32 nextPriority();
+
+    static void push(Node *node);
+    static void update(Node *node);
+    static void move(Node *node, int delta);
+    static void split(Node *node, int start, Node *&left, Node *&right);
+    static Node *merge(Node *left, Node *right);
+    static void destroy(Node *node);
+    static void collect(const Node *node, int offset, int first, int last, QVector<Range> &ranges);
+    static void shiftEnds(Node *node, int from, int delta);
+};
+
+#endif   // FOLDRANGETREE_H
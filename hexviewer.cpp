@@ -0,0 +1,468 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#include "hexviewer.h"
+
+#include <QMessageBox>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QScrollBar>
+#include <QtConcurrent>
+
+#include <cstring>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const int BytesPerRow = 16;
+// a multiple of the row length, rows never span two pages
+const qint64 PageSize = 1024 * 1024;
+const int MaxPages = 4;
+const qint64 SearchWindow = 16 * 1024 * 1024;
+const qint64 BinaryProbeSize = 8192;
+
+const char HexDigits[] = "0123456789abcdef";
+
+// two lower case hex digits per input byte
+void formatHex(const uchar *in, qint64 count, char *out)
+{
+    qint64 i = 0;
+#ifdef __SSE2__
+    const __m128i mask      = _mm_set1_epi8(0x0f);
+    const __m128i nine      = _mm_set1_epi8(9);
+    const __m128i zero      = _mm_set1_epi8('0');
+    const __m128i letterGap = _mm_set1_epi8('a' - '0' - 10);
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        const __m128i high  = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+        const __m128i low   = _mm_and_si128(bytes, mask);
+
+        // nibble + '0', plus the gap up to 'a' for nibbles above nine
+        const __m128i highDigits = _mm_add_epi8(_mm_add_epi8(high, zero),
+                                                _mm_and_si128(_mm_cmpgt_epi8(high, nine), letterGap));
+        const __m128i lowDigits  = _mm_add_epi8(_mm_add_epi8(low, zero),
+                                                _mm_and_si128(_mm_cmpgt_epi8(low, nine), letterGap));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(highDigits, lowDigits));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(highDigits, lowDigits));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[2 * i]     = HexDigits[in[i] >> 4];
+        out[2 * i + 1] = HexDigits[in[i] & 0x0f];
+    }
+}
+
+// offset of the next match after from (or before it when backwards),
+// -1 without one; runs on a worker with its own mapping of the file
+qint64 scanFile(const QString &fileName, qint64 size, const QByteArray &pattern, qint64 from, bool forward,
+                QSharedPointer<QAtomicInt> canceled)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return -1;
+    }
+
+    if (forward)
+    {
+        qint64 pos = from < 0 ? 0 : from + 1;
+        while (pos + pattern.size() <= size && canceled->loadRelaxed() == 0)
+        {
+            const qint64 length = qMin(SearchWindow + pattern.size() - 1, size - pos);
+            uchar *data = file.map(pos, length);
+            if (data == nullptr)
+            {
+                return -1;
+            }
+            const qint64 index = QByteArray::fromRawData(reinterpret_cast<const char *>(data), length).indexOf(pattern);
+            file.unmap(data);
+            if (index >= 0)
+            {
+                return pos + index;
+            }
+            pos += SearchWindow;
+        }
+        return -1;
+    }
+
+    // matches starting before from, window by window backwards
+    qint64 limit = from < 0 ? size : from;
+    while (limit > 0 && canceled->loadRelaxed() == 0)
+    {
+        const qint64 start  = qMax<qint64>(0, limit - SearchWindow);
+        const qint64 length = qMin(limit - 1 + pattern.size(), size) - start;
+        uchar *data = file.map(start, length);
+        if (data == nullptr)
+        {
+            return -1;
+        }
+        const qint64 index = QByteArray::fromRawData(reinterpret_cast<const char *>(data), length).lastIndexOf(pattern);
+        file.unmap(data);
+        if (index >= 0)
+        {
+            return start + index;
+        }
+        limit = start;
+    }
+    return -1;
+}
+
+} // namespace
+
+HexViewer::HexViewer(QWidget *parent, const QString& fileName)
+    : QAbstractScrollArea(parent)
+    , m_fileName(fileName)
+    , m_file(fileName)
+    , m_size(0)
+    , m_cursorOffset(-1)
+    , m_matchLength(0)
+    , m_rowScale(1)
+    , m_offsetDigits(8)
+    , m_pageClock(0)
+{
+    connect(&m_findWatcher, &QFutureWatcherBase::finished, this, &HexViewer::findFinished);
+
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        QMessageBox::critical(this, tr("Critical"), tr("Cannot read file: ") + m_file.errorString());
+    }
+    else
+    {
+        m_size = m_file.size();
+    }
+
+    int digits = 1;
+    for (qint64 size = m_size; size >= 16; size /= 16)
+    {
+        digits++;
+    }
+    m_offsetDigits = qMax(8, digits);
+
+    updateScrollBar();
+}
+
+HexViewer::~HexViewer()
+{
+    cancelFind();
+    for (const Page &page : m_pages)
+    {
+        m_file.unmap(page.data);
+    }
+    m_file.close();
+}
+
+bool HexViewer::isBinaryFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    const QByteArray head = file.read(BinaryProbeSize);
+    file.close();
+    if (head.isEmpty())
+    {
+        return false;
+    }
+
+    // UTF-16 text is full of zero bytes but carries a byte order mark
+    if (head.startsWith("\xff\xfe") || head.startsWith("\xfe\xff"))
+    {
+        return false;
+    }
+    if (head.contains('\0'))
+    {
+        return true;
+    }
+
+    int control = 0;
+    for (const char c : head)
+    {
+        const uchar u = uchar(c);
+        if (u < 0x20 && u != '\t' && u != '\n' && u != '\r' && u != '\f' && u != '\b' && u != 0x1b)
+        {
+            control++;
+        }
+    }
+    return control * 10 > head.size();
+}
+
+void HexViewer::find(const QString &text, bool forward)
+{
+    // "7f 45 4c 46" or "0x7f454c46" are bytes, anything else is text
+    static const QRegularExpression hexBytes("^\\s*[0-9a-fA-F]{2}(\\s+[0-9a-fA-F]{2})+\\s*$");
+    static const QRegularExpression hexNumber("^\\s*0[xX]((?:[0-9a-fA-F]{2})+)\\s*$");
+
+    cancelFind();
+
+    QByteArray pattern;
+    const QRegularExpressionMatch number = hexNumber.match(text);
+    if (number.hasMatch())
+    {
+        pattern = QByteArray::fromHex(number.captured(1).toLatin1());
+    }
+    else if (hexBytes.match(text).hasMatch())
+    {
+        pattern = QByteArray::fromHex(text.toLatin1());
+    }
+    else
+    {
+        pattern = text.toUtf8();
+    }
+    if (pattern.isEmpty() || pattern.size() > m_size)
+    {
+        return;
+    }
+
+    // a new pattern starts at the top, the same one goes on from the match
+    const qint64 from = pattern != m_findPattern ? -1 : m_cursorOffset;
+    m_findPattern = pattern;
+    m_findCanceled.reset(new QAtomicInt(0));
+    const QString fileName = m_fileName;
+    const qint64 size = m_size;
+    const QSharedPointer<QAtomicInt> canceled = m_findCanceled;
+    m_findWatcher.setFuture(QtConcurrent::run([=]() {
+        return scanFile(fileName, size, pattern, from, forward, canceled);
+    }));
+}
+
+void HexViewer::cancelFind()
+{
+    if (!m_findCanceled.isNull())
+    {
+        m_findCanceled->storeRelaxed(1);
+        m_findCanceled.reset();
+    }
+}
+
+void HexViewer::findFinished()
+{
+    // the text changed while scanning
+    if (m_findCanceled.isNull())
+    {
+        return;
+    }
+    const qint64 found = m_findWatcher.result();
+    if (found < 0)
+    {
+        return;
+    }
+    m_cursorOffset = found;
+    m_matchLength  = m_findPattern.size();
+    scrollToOffset(found);
+}
+
+void HexViewer::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(viewport());
+    painter.setFont(font());
+
+    const QFontMetrics metrics(font());
+    const int charWidth  = metrics.horizontalAdvance('0');
+    const int lineHeight = metrics.height();
+    const int gutterWidth = (m_offsetDigits + 1) * charWidth;
+
+    painter.translate(-horizontalScrollBar()->value(), 0);
+    painter.fillRect(0, 0, gutterWidth, viewport()->height(), QColor(200, 200, 200, 100));
+
+    const qint64 firstRow = topRow();
+    const qint64 begin    = qMin(firstRow * BytesPerRow, m_size);
+    const qint64 end      = qMin((firstRow + visibleRows() + 1) * BytesPerRow, m_size);
+    if (begin >= end)
+    {
+        return;
+    }
+
+    // gather the visible bytes, at most two pages are involved
+    QByteArray bytes(end - begin, '\0');
+    for (qint64 offset = begin; offset < end;)
+    {
+        qint64 pageSize;
+        const qint64 index = offset / PageSize;
+        const uchar *page  = pageData(index, &pageSize);
+        if (page == nullptr)
+        {
+            return;
+        }
+        const qint64 pageOffset = offset - index * PageSize;
+        const qint64 count      = qMin(pageSize - pageOffset, end - offset);
+        memcpy(bytes.data() + (offset - begin), page + pageOffset, count);
+        offset += count;
+    }
+
+    QByteArray hex(bytes.size() * 2, '\0');
+    formatHex(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size(), hex.data());
+
+    const int lineLength = asciiColumn() - hexColumn() + BytesPerRow;
+    QByteArray line(lineLength, ' ');
+    int y = 0;
+    for (qint64 rowOffset = begin; rowOffset < end; rowOffset += BytesPerRow, y += lineHeight)
+    {
+        const int count = int(qMin<qint64>(BytesPerRow, end - rowOffset));
+        const int first = int(rowOffset - begin);
+
+        line.fill(' ');
+        for (int i = 0; i < count; i++)
+        {
+            const uchar c = uchar(bytes.at(first + i));
+            line[3 * i]     = hex.at(2 * (first + i));
+            line[3 * i + 1] = hex.at(2 * (first + i) + 1);
+            line[asciiColumn() - hexColumn() + i] = c >= 0x20 && c < 0x7f ? char(c) : '.';
+        }
+
+        // current byte or search match
+        const qint64 matchEnd = m_cursorOffset + qMax<qint64>(1, m_matchLength);
+        if (m_cursorOffset >= 0 && m_cursorOffset < rowOffset + count && matchEnd > rowOffset)
+        {
+            const int from = int(qMax(m_cursorOffset, rowOffset) - rowOffset);
+            const int to   = int(qMin(matchEnd, rowOffset + count) - rowOffset);
+            painter.fillRect((hexColumn() + 3 * from) * charWidth, y, (3 * (to - from) - 1) * charWidth, lineHeight, Qt::yellow);
+            painter.fillRect((asciiColumn() + from) * charWidth, y, (to - from) * charWidth, lineHeight, Qt::yellow);
+        }
+
+        painter.setPen(QColor(80, 80, 80));
+        painter.drawText(0, y + metrics.ascent(), QString("%1").arg(rowOffset, m_offsetDigits, 16, QChar('0')));
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(hexColumn() * charWidth, y + metrics.ascent(), QString::fromLatin1(line));
+    }
+}
+
+void HexViewer::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBar();
+}
+
+void HexViewer::mousePressEvent(QMouseEvent *event)
+{
+    const QFontMetrics metrics(font());
+    const int column = (event->pos().x() + horizontalScrollBar()->value()) / metrics.horizontalAdvance('0');
+    const qint64 row = topRow() + event->pos().y() / metrics.height();
+
+    int byte = -1;
+    if (column >= hexColumn() && column < hexColumn() + 3 * BytesPerRow)
+    {
+        byte = (column - hexColumn()) / 3;
+    }
+    else if (column >= asciiColumn() && column < asciiColumn() + BytesPerRow)
+    {
+        byte = column - asciiColumn();
+    }
+
+    const qint64 offset = row * BytesPerRow + byte;
+    if (byte >= 0 && offset < m_size)
+    {
+        m_cursorOffset = offset;
+        m_matchLength  = 0;
+        viewport()->update();
+    }
+}
+
+void HexViewer::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange)
+    {
+        updateScrollBar();
+        viewport()->update();
+    }
+}
+
+const uchar *HexViewer::pageData(qint64 index, qint64 *size)
+{
+    m_pageClock++;
+    for (Page &page : m_pages)
+    {
+        if (page.index == index)
+        {
+            page.lastUse = m_pageClock;
+            *size = page.size;
+            return page.data;
+        }
+    }
+
+    // drop the least recently used page, memory use stays constant
+    if (m_pages.size() >= MaxPages)
+    {
+        int oldest = 0;
+        for (int i = 1; i < m_pages.size(); i++)
+        {
+            if (m_pages.at(i).lastUse < m_pages.at(oldest).lastUse)
+            {
+                oldest = i;
+            }
+        }
+        m_file.unmap(m_pages.at(oldest).data);
+        m_pages.remove(oldest);
+    }
+
+    Page page;
+    page.index   = index;
+    page.size    = qMin(PageSize, m_size - index * PageSize);
+    page.data    = m_file.map(index * PageSize, page.size);
+    page.lastUse = m_pageClock;
+    if (page.data == nullptr)
+    {
+        return nullptr;
+    }
+    m_pages.append(page);
+    *size = page.size;
+    return page.data;
+}
+
+qint64 HexViewer::rowCount() const
+{
+    return (m_size + BytesPerRow - 1) / BytesPerRow;
+}
+
+qint64 HexViewer::topRow() const
+{
+    const qint64 maxTop = qMax<qint64>(0, rowCount() - visibleRows());
+    return qMin(qint64(verticalScrollBar()->value()) * m_rowScale, maxTop);
+}
+
+int HexViewer::visibleRows() const
+{
+    return qMax(1, viewport()->height() / QFontMetrics(font()).height());
+}
+
+int HexViewer::asciiColumn() const
+{
+    return hexColumn() + 3 * BytesPerRow + 1;
+}
+
+void HexViewer::updateScrollBar()
+{
+    // beyond the int range of QScrollBar one step covers several rows
+    const qint64 maxTop = qMax<qint64>(0, rowCount() - visibleRows());
+    m_rowScale = maxTop / std::numeric_limits<int>::max() + 1;
+
+    verticalScrollBar()->setRange(0, int(maxTop / m_rowScale));
+    verticalScrollBar()->setPageStep(qMax<qint64>(1, visibleRows() / m_rowScale));
+    verticalScrollBar()->setSingleStep(1);
+
+    const int width = (asciiColumn() + BytesPerRow + 1) * QFontMetrics(font()).horizontalAdvance('0');
+    horizontalScrollBar()->setRange(0, qMax(0, width - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+}
+
+void HexViewer::scrollToOffset(qint64 offset)
+{
+    const qint64 row = offset / BytesPerRow;
+    if (row < topRow() || row >= topRow() + visibleRows())
+    {
+        const qint64 top = qMax<qint64>(0, row - visibleRows() / 2);
+        verticalScrollBar()->setValue(int(top / m_rowScale));
+    }
+    viewport()->update();
+}
@@ -0,0 +1,82 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#ifndef HEXVIEWER_H
+#define HEXVIEWER_H
+
+#include <QAbstractScrollArea>
+#include <QAtomicInt>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QVector>
+
+/*
+ * Read only hex view of a file.
+ *
+ * The file is memory-mapped in fixed-size pages, only a few of them are
+ * kept mapped, and only the rows inside the viewport are formatted.
+ */
+class HexViewer : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    HexViewer(QWidget *parent, const QString& fileName);
+    ~HexViewer();
+
+    QString path() const { return m_fileName; }
+
+    QString fileName() const
+    {
+        QFileInfo info(m_fileName);
+        return info.fileName();
+    }
+
+    void find(const QString &text, bool forward);
+    void cancelFind();
+
+    static bool isBinaryFile(const QString &fileName);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+private slots:
+    void findFinished();
+
+private:
+    struct Page
+    {
+        qint64 index;
+        uchar *data;
+        qint64 size;
+        quint64 lastUse;
+    };
+
+    QString m_fileName;
+    QFile m_file;
+    qint64 m_size;
+    qint64 m_cursorOffset;
+    qint64 m_matchLength;
+    qint64 m_rowScale;
+    int m_offsetDigits;
+    QVector<Page> m_pages;
+    quint64 m_pageClock;
+    QByteArray m_findPattern;
+    QSharedPointer<QAtomicInt> m_findCanceled;
+    QFutureWatcher<qint64> m_findWatcher;
+
+    const uchar *pageData(qint64 index, qint64 *size);
+    qint64 rowCount() const;
+    qint64 topRow() const;
+    int visibleRows() const;
+    int hexColumn() const { return m_offsetDigits + 2; }
+    int asciiColumn() const;
+    void updateScrollBar();
+    void scrollToOffset(qint64 offset);
+};
+
+#endif   // HEXVIEWER_H
@@ -0,0 +1,325 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#include "identifierindex.h"
+
+#include <QQueue>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace {
+
+// shorter words are not worth completing, longer ones are rarely typed
+const int MinIdentifierLength = 3;
+const int MaxIdentifierLength = 64;
+// trie nodes visited per lookup at most, keeps short prefixes fast
+const int MaxVisitedNodes = 20000;
+// words changed per write lock, lookups never wait for a whole document
+const int SliceSize = 1024;
+// a full trie forgets this many of its least recently seen words at once
+const int EvictCount = 5000;
+
+} // namespace
+
+IdentifierIndex::IdentifierIndex()
+    : m_words(0)
+    , m_clock(0)
+{
+    // a single worker applies the updates in the order they were made
+    m_worker.setMaxThreadCount(1);
+}
+
+IdentifierIndex::~IdentifierIndex()
+{
+    m_worker.waitForDone();
+}
+
+void IdentifierIndex::update(const QVector<WordHash> &removed, const QStringList &added)
+{
+    if (removed.isEmpty() && added.isEmpty())
+    {
+        return;
+    }
+
+    m_worker.start([this, removed, added]() {
+        for (int i = 0; i < removed.size(); i += SliceSize)
+        {
+            QWriteLocker locker(&m_lock);
+            for (int j = i; j < qMin(i + SliceSize, int(removed.size())); j++)
+            {
+                remove(removed.at(j), false);
+            }
+        }
+        for (int i = 0; i < added.size(); i += SliceSize)
+        {
+            const int end = qMin(i + SliceSize, int(added.size()));
+            makeRoom(end - i);
+            QWriteLocker locker(&m_lock);
+            for (int j = i; j < end; j++)
+            {
+                insert(added.at(j), 1);
+            }
+        }
+    });
+}
+
+void IdentifierIndex::add(const QHash<QString, int> &counts)
+{
+    if (counts.isEmpty())
+    {
+        return;
+    }
+
+    m_worker.start([this, counts]() {
+        auto it = counts.constBegin();
+        int remaining = counts.size();
+        while (it != counts.constEnd())
+        {
+            makeRoom(qMin(SliceSize, remaining));
+            remaining -= SliceSize;
+            QWriteLocker locker(&m_lock);
+            for (int i = 0; i < SliceSize && it != counts.constEnd(); i++, ++it)
+            {
+                insert(it.key(), it.value());
+            }
+        }
+    });
+}
+
+QFuture<IdentifierIndex::Snapshot> IdentifierIndex::tokenize(const QString &text)
+{
+    // leaves the trie alone, the caller adds the counts once it keeps
+    // the line hashes
+    return QtConcurrent::run(&m_worker, [text]() {
+        Snapshot snapshot;
+        const QStringList lines = text.split(QLatin1Char('\n'));
+        snapshot.lines.reserve(lines.size());
+        for (const QString &line : lines)
+        {
+            const QStringList words = identifiers(line);
+            for (const QString &word : words)
+            {
+                snapshot.counts[word]++;
+            }
+            snapshot.lines.append(hashes(words));
+        }
+        return snapshot;
+    });
+}
+
+QStringList IdentifierIndex::complete(const QString &prefix, int limit) const
+{
+    QReadLocker locker(&m_lock);
+
+    const Node *node = &m_root;
+    for (const QChar c : prefix)
+    {
+        node = node->children.value(c);
+        if (node == nullptr)
+        {
+            return QStringList();
+        }
+    }
+
+    // breadth first, so the shortest completions come first
+    QStringList words;
+    QQueue<QPair<const Node *, QString>> queue;
+    queue.enqueue(qMakePair(node, prefix));
+    int visited = 0;
+    while (!queue.isEmpty() && words.size() < limit && visited < MaxVisitedNodes)
+    {
+        const QPair<const Node *, QString> entry = queue.dequeue();
+        visited++;
+        if (entry.first->count > 0 && entry.second != prefix)
+        {
+            words.append(entry.second);
+        }
+        for (auto it = entry.first->children.constBegin(); it != entry.first->children.constEnd(); ++it)
+        {
+            queue.enqueue(qMakePair(static_cast<const Node *>(it.value()), entry.second + it.key()));
+        }
+    }
+
+    std::sort(words.begin(), words.end(), [](const QString &a, const QString &b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    return words;
+}
+
+QStringList IdentifierIndex::identifiers(const QString &text)
+{
+    QStringList words;
+    const int length = text.size();
+    int i = 0;
+    while (i < length)
+    {
+        const QChar c = text.at(i);
+        if (!isIdentifierChar(c))
+        {
+            i++;
+            continue;
+        }
+
+        const int start = i;
+        while (i < length && isIdentifierChar(text.at(i)))
+        {
+            i++;
+        }
+
+        // numbers like 0x1f are no identifiers
+        const int size = i - start;
+        if (c.isDigit() || size < MinIdentifierLength || size > MaxIdentifierLength)
+        {
+            continue;
+        }
+        const QString word = text.mid(start, size);
+        if (!words.contains(word))
+        {
+            words.append(word);
+        }
+    }
+    return words;
+}
+
+IdentifierIndex::WordHash IdentifierIndex::hash(const QString &word)
+{
+    // 64-bit FNV-1a, collisions between the words of open documents are
+    // not to be expected
+    WordHash result = Q_UINT64_C(14695981039346656037);
+    for (const QChar c : word)
+    {
+        result ^= c.unicode();
+        result *= Q_UINT64_C(1099511628211);
+    }
+    return result;
+}
+
+QVector<IdentifierIndex::WordHash> IdentifierIndex::hashes(const QStringList &words)
+{
+    QVector<WordHash> result;
+    result.reserve(words.size());
+    for (const QString &word : words)
+    {
+        result.append(hash(word));
+    }
+    return result;
+}
+
+void IdentifierIndex::makeRoom(int words)
+{
+    if (m_words + words <= MaxWords)
+    {
+        return;
+    }
+
+    // only this worker writes, so the stamps are read without the lock
+    QVector<QPair<quint64, WordHash>> stamps;
+    stamps.reserve(m_hashes.size());
+    for (auto it = m_hashes.constBegin(); it != m_hashes.constEnd(); ++it)
+    {
+        stamps.append(qMakePair(it.value().stamp, it.key()));
+    }
+    const int count = qMin(int(stamps.size()), qMax(EvictCount, m_words + words - MaxWords));
+    if (count <= 0)
+    {
+        return;
+    }
+    std::nth_element(stamps.begin(), stamps.begin() + count - 1, stamps.end());
+
+    for (int i = 0; i < count; i += SliceSize)
+    {
+        QWriteLocker locker(&m_lock);
+        for (int j = i; j < qMin(i + SliceSize, count); j++)
+        {
+            remove(stamps.at(j).second, true);
+        }
+    }
+}
+
+void IdentifierIndex::insert(const QString &word, int count)
+{
+    // a word whose hash is taken by another one is not indexed
+    const WordHash key = hash(word);
+    const auto known = m_hashes.find(key);
+    if (known != m_hashes.end())
+    {
+        if (known.value().word != word)
+        {
+            return;
+        }
+        known.value().stamp = ++m_clock;
+    }
+    else if (m_words >= MaxWords)
+    {
+        return;
+    }
+
+    Node *node = &m_root;
+    for (const QChar c : word)
+    {
+        Node *child = node->children.value(c);
+        if (child == nullptr)
+        {
+            child = new Node;
+            node->children.insert(c, child);
+        }
+        node = child;
+    }
+
+    if (node->count == 0)
+    {
+        m_words++;
+        m_hashes.insert(key, { word, ++m_clock });
+    }
+    node->count += count;
+}
+
+void IdentifierIndex::remove(WordHash key, bool all)
+{
+    // words that were never indexed, or were evicted, are not known
+    const auto known = m_hashes.constFind(key);
+    if (known == m_hashes.constEnd())
+    {
+        return;
+    }
+    const QString word = known.value().word;
+
+    QVector<Node *> path;
+    path.reserve(word.size() + 1);
+    path.append(&m_root);
+    for (const QChar c : word)
+    {
+        Node *child = path.last()->children.value(c);
+        if (child == nullptr)
+        {
+            return;
+        }
+        path.append(child);
+    }
+
+    Node *node = path.last();
+    if (node->count == 0)
+    {
+        return;
+    }
+    node->count = all ? 0 : node->count - 1;
+    if (node->count > 0)
+    {
+        return;
+    }
+    m_words--;
+    m_hashes.remove(key);
+    // drop the nodes no other word passes through
+    for (int i = path.size() - 1; i > 0; i--)
+    {
+        Node *child = path.at(i);
+        if (child->count > 0 || !child->children.isEmpty())
+        {
+            break;
+        }
+        path.at(i - 1)->children.remove(word.at(i - 1));
+        delete child;
+    }
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#ifndef IDENTIFIERINDEX_H
+#define IDENTIFIERINDEX_H
+
+#include <QFuture>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+/*
+ * Identifiers of all open documents for completion.
+ *
+ * A trie with hashed children, counting in how many lines each word
+ * occurs. Editors keep only the hashes of the words of each line and
+ * send the removed hashes and the added words of the lines they changed;
+ * the trie is updated in order on a worker thread, in slices so lookups
+ * do not wait for large batches. It holds at most MaxWords words and
+ * forgets the least recently seen ones when full. Whole documents are
+ * tokenized on the same worker.
+ */
+class IdentifierIndex
+{
+public:
+    typedef quint64 WordHash;
+
+    // word hashes of every line and line counts of every word of a text
+    struct Snapshot
+    {
+        QVector<QVector<WordHash>> lines;
+        QHash<QString, int> counts;
+    };
+
+    IdentifierIndex();
+    ~IdentifierIndex();
+
+    void update(const QVector<WordHash> &removed, const QStringList &added);
+    void add(const QHash<QString, int> &counts);
+    QFuture<Snapshot> tokenize(const QString &text);
+    QStringList complete(const QString &prefix, int limit) const;
+
+    static QStringList identifiers(const QString &text);
+    static WordHash hash(const QString &word);
+    static QVector<WordHash> hashes(const QStringList &words);
+    static bool isIdentifierChar(QChar c) { return c.isLetterOrNumber() || c == '_'; }
+
+private:
+    struct Node
+    {
+        Node() : count(0) {}
+        ~Node() { qDeleteAll(children); }
+
+        QHash<QChar, Node *> children;
+        int count;
+    };
+
+    // an indexed word and when it was last added
+    struct Entry
+    {
+        QString word;
+        quint64 stamp;
+    };
+
+    static constexpr int MaxWords = 50000;
+
+    Node m_root;
+    int m_words;
+    quint64 m_clock;
+    QHash<WordHash, Entry> m_hashes;
+    mutable QReadWriteLock m_lock;
+    QThreadPool m_worker;
+
+    void makeRoom(int words);
+    void insert(const QString &word, int count);
+    void remove(WordHash key, bool all);
+};
+
+#endif   // IDENTIFIERINDEX_H
@@ -10,11 +10,17 @@
 #include <QPrinter>
 #include <QFont>
 #include <QFontDialog>
+#include <QInputDialog>
 #include <QPainter>
 #include <QTabBar>
+#include <QTimer>
 #include <QToolBar>
 
+#include "compressedfile.h"
+#include "hexviewer.h"
+#include "identifierindex.h"
 #include "librepad.h"
+#include "tableviewer.h"
 #include "texteditor.h"
 #include "ui_librepad.h"
 
@@ -23,6 +29,8 @@ Librepad::Librepad(QWidget *parent, const QString& fileName)
     , m_fileName(fileName)
     , m_font(QFont("Monospace",10))
     , ui(new Ui::Librepad)
+    , m_identifierIndex(new IdentifierIndex)
+    , m_searchIndex(0)
 {
     this->hide();
     ui->setupUi(this);
@@ -36,6 +44,7 @@ Librepad::Librepad(QWidget *parent, const QString& fileName)
     connect(ui->tabWidget, &QTabWidget::tabCloseRequested, this, &Librepad::slotTabClose);
     connect(ui->actionNew, &QAction::triggered, this, &Librepad::newDocument);
     connect(ui->actionOpen, &QAction::triggered, this, &Librepad::open);
+    connect(ui->actionOpenAsTable, &QAction::triggered, this, &Librepad::openAsTable);
     connect(ui->actionSave, &QAction::triggered, this, &Librepad::save);
     connect(ui->actionSave_as, &QAction::triggered, this, &Librepad::saveAs);
     connect(ui->actionReload, &QAction::triggered, this, &Librepad::reload);
@@ -44,6 +53,9 @@ Librepad::Librepad(QWidget *parent, const QString& fileName)
     connect(ui->actionUndo, &QAction::triggered, this, &Librepad::undo);
     connect(ui->actionRedo, &QAction::triggered, this, &Librepad::redo);
     connect(ui->actionFont, &QAction::triggered, this, &Librepad::setFont);
+    connect(ui->actionTableView, &QAction::triggered, this, &Librepad::tableView);
+    connect(ui->actionGoToLine, &QAction::triggered, this, &Librepad::goToLine);
+    connect(ui->actionSelectAllMatches, &QAction::triggered, this, &Librepad::selectAllMatches);
     connect(ui->actionAbout, &QAction::triggered, this, &Librepad::about);
     connect(ui->actionPrevious, &QAction::triggered, this, [=]() {
         slotSearchChanged(m_searchLineEdit->text(), false, false);
@@ -53,6 +65,8 @@ Librepad::Librepad(QWidget *parent, const QString& fileName)
     });
     connect(m_searchLineEdit, &QLineEdit::textChanged, this, [=]() {
         slotSearchChanged(m_searchLineEdit->text(), true, true);});
+    connect(m_searchLineEdit, &QLineEdit::returnPressed, this, [=]() {
+        slotSearchChanged(m_searchLineEdit->text(), true, false);});
 
     connect(ui->actionCopy, &QAction::triggered, this, &Librepad::copy);
     connect(ui->actionPaste, &QAction::triggered, this, &Librepad::paste);
@@ -64,9 +78,22 @@ Librepad::Librepad(QWidget *parent, const QString& fileName)
 }
 
 void Librepad::slotTabChanged(int index) {
+    if (ui->tabWidget->widget(index) == nullptr)
+    {
+        return;
+    }
+
+    // a tab still waiting for a new font gets it before it is painted
+    if (ui->tabWidget->widget(index)->font() != m_font)
+    {
+        ui->tabWidget->widget(index)->setFont(m_font);
+    }
+
     TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(index));
     if (editor == nullptr)
     {
+        // viewer tabs are titled with their file name
+        setWindowTitle(ui->tabWidget->tabText(index));
         return;
     }
 
@@ -89,7 +116,7 @@ void Librepad::closeEvent(QCloseEvent *event)
         TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(i));
         if (editor == nullptr)
         {
-            return;
+            continue;
         }
 
         if (editor->document()->isModified())
@@ -165,6 +192,22 @@ void Librepad::paste()
 void Librepad::slotSearchChanged(const QString &text, bool direction, bool reset)
 {
     QString search_text = text;
+
+    // a scan of a large file runs on return or next, not on every key
+    HexViewer *viewer = dynamic_cast<HexViewer *>(ui->tabWidget->currentWidget());
+    if (viewer != nullptr)
+    {
+        if (reset)
+        {
+            viewer->cancelFind();
+        }
+        else if (!search_text.trimmed().isEmpty())
+        {
+            viewer->find(search_text, direction);
+        }
+        return;
+    }
+
     if (search_text.trimmed().isEmpty())
     {
         return;
@@ -179,8 +222,6 @@ void Librepad::slotSearchChanged(const QString &text, bool direction, bool reset
     QTextDocument *document = editor->document();
     QTextCursor    cur      = editor->textCursor();
 
-    static QList<QTextCursor> highlight_cursors;
-    static int                index = 0;
     if (reset)
     {
         /* Traverse and search all */
@@ -188,43 +229,44 @@ void Librepad::slotSearchChanged(const QString &text, bool direction, bool reset
         cur.clearSelection();
         cur.movePosition(QTextCursor::Start);
 
-        highlight_cursors.clear();
+        m_searchCursors.clear();
         QTextCursor highlight_cursor = document->find(search_text);
         while (!highlight_cursor.isNull())
         {
-            highlight_cursors.append(highlight_cursor);
+            m_searchCursors.append(highlight_cursor);
             highlight_cursor = document->find(search_text, highlight_cursor);
         }
     }
-    else
+    else if (!m_searchCursors.isEmpty())
     {
         if (direction)
         {
-            index += 1;
+            m_searchIndex += 1;
         }
         else
         {
-            index -= 1;
+            m_searchIndex -= 1;
         }
-        index = qMax(0, index);
+        m_searchIndex = qMax(0, m_searchIndex);
 
-        index = index % highlight_cursors.size();
+        m_searchIndex = m_searchIndex % m_searchCursors.size();
     }
 
     QList<QTextEdit::ExtraSelection> list; /* = editor->extraSelections();*/
 
-    if (highlight_cursors.size() > 0 && index < highlight_cursors.size())
+    if (m_searchCursors.size() > 0 && m_searchIndex < m_searchCursors.size())
     {
         QTextCharFormat highlightFormat;
         highlightFormat.setBackground(Qt::yellow);
         highlightFormat.setForeground(Qt::blue);
         QTextEdit::ExtraSelection selection;
-        selection.cursor = highlight_cursors[index];
+        selection.cursor = m_searchCursors[m_searchIndex];
         selection.format = highlightFormat;
 
         list.append(selection);
 
-        editor->setTextCursor(highlight_cursors[index]);
+        editor->clearCarets();
+        editor->setTextCursor(m_searchCursors[m_searchIndex]);
         editor->setExtraSelections(list);
     }
 }
@@ -234,6 +276,11 @@ void Librepad::slotTabClose(int index)
     TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(index));
     if (editor == nullptr)
     {
+        // viewer tabs are read only, nothing to save
+        QWidget *viewer = ui->tabWidget->widget(index);
+        ui->tabWidget->removeTab(index);
+        setWindowTitle("Librepad");
+        delete viewer;
         return;
     }
 
@@ -255,10 +302,20 @@ void Librepad::slotTabClose(int index)
 
 void Librepad::addNewTab(QString fileName)
 {
+    // binary files are not pushed through text decoding, compressed
+    // ones are unpacked by the editor
+    if (!fileName.isEmpty()
+        && !CompressedFile::isSupported(CompressedFile::format(fileName))
+        && HexViewer::isBinaryFile(fileName))
+    {
+        addViewerTab(new HexViewer(this, fileName), fileName);
+        return;
+    }
+
     QFileInfo info(fileName);
-    TextEditor *editor = new TextEditor(this, fileName);
+    TextEditor *editor = new TextEditor(this, fileName, m_font);
 
-    editor->setFont(m_font);
+    editor->setIdentifierIndex(m_identifierIndex);
 
     ui->tabWidget->addTab(editor, info.fileName());
     int index = ui->tabWidget->count() - 1;
@@ -275,6 +332,18 @@ void Librepad::addNewTab(QString fileName)
     editor->setFocus();
 }
 
+void Librepad::addViewerTab(QWidget *viewer, const QString &fileName)
+{
+    QFileInfo info(fileName);
+    viewer->setFont(m_font);
+
+    ui->tabWidget->addTab(viewer, info.fileName());
+    int index = ui->tabWidget->count() - 1;
+    ui->tabWidget->setCurrentIndex(index);
+    ui->tabWidget->tabBar()->setTabToolTip(index, fileName);
+    setWindowTitle(info.fileName());
+}
+
 Librepad::~Librepad()
 {
     delete ui;
@@ -301,6 +370,22 @@ void Librepad::open()
     addNewTab(fileName);
 }
 
+void Librepad::openAsTable()
+{
+    // the table maps the file itself, large logs never pass through an editor
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open as table"), QString(),
+                                                    tr("Tables and logs (*.csv *.tsv *.log *.txt);;All Files (*)"));
+    if (fileName.isEmpty())
+        return;
+
+    if (CompressedFile::format(fileName) != CompressedFile::None)
+    {
+        QMessageBox::warning(this, tr("Warning"), tr("Compressed files cannot be shown as table."));
+        return;
+    }
+    addViewerTab(new TableViewer(this, fileName), fileName);
+}
+
 void Librepad::save()
 {
     TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(ui->tabWidget->currentIndex()));
@@ -335,19 +420,102 @@ void Librepad::setFont()
 {
     bool ok;
     QFont font = QFontDialog::getFont(
-        &ok, QFont("Monospace", 10), this);
+        &ok, m_font, this);
     if (ok) {
-        TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(ui->tabWidget->currentIndex()));
-        if (editor == nullptr)
-        {
-            return;
-        }
         m_font = font;
         writeFontSettings();
-        editor->setFont(font);
+        applyFont();
+    }
+}
+
+void Librepad::applyFont()
+{
+    // only the shown tab is laid out now, the others follow when idle
+    // or when they are activated
+    m_fontPending.clear();
+    for (int i = 0; i < ui->tabWidget->count(); i++) {
+        QWidget *widget = ui->tabWidget->widget(i);
+        if (widget == ui->tabWidget->currentWidget()) {
+            widget->setFont(m_font);
+        }
+        else {
+            m_fontPending.append(widget);
+        }
+    }
+    QTimer::singleShot(0, this, &Librepad::applyPendingFont);
+}
+
+void Librepad::applyPendingFont()
+{
+    // one tab per event loop pass keeps the window responsive
+    while (!m_fontPending.isEmpty()) {
+        QPointer<QWidget> widget = m_fontPending.takeFirst();
+        if (!widget.isNull() && widget->font() != m_font) {
+            widget->setFont(m_font);
+            break;
+        }
+    }
+    if (!m_fontPending.isEmpty()) {
+        QTimer::singleShot(0, this, &Librepad::applyPendingFont);
+    }
+}
+
+void Librepad::tableView()
+{
+    TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(ui->tabWidget->currentIndex()));
+    if (editor == nullptr)
+    {
+        return;
+    }
+
+    // the table reads the file on disk, not the editor content
+    if (!QFileInfo::exists(editor->path()))
+    {
+        QMessageBox::warning(this, tr("Warning"), tr("Save the document before showing it as table."));
+        return;
+    }
+    if (CompressedFile::format(editor->path()) != CompressedFile::None)
+    {
+        QMessageBox::warning(this, tr("Warning"), tr("Compressed files cannot be shown as table."));
+        return;
+    }
+    addViewerTab(new TableViewer(this, editor->path()), editor->path());
+}
+
+void Librepad::goToLine()
+{
+    TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(ui->tabWidget->currentIndex()));
+    if (editor == nullptr)
+    {
+        return;
+    }
+
+    bool ok;
+    const int line = QInputDialog::getInt(this, tr("Go to line"), tr("Line:"),
+                                          editor->textCursor().blockNumber() + 1, 1, editor->blockCount(), 1, &ok);
+    if (ok) {
+        editor->goToLine(line);
     }
 }
 
+void Librepad::selectAllMatches()
+{
+    TextEditor *editor = dynamic_cast<TextEditor *>(ui->tabWidget->widget(ui->tabWidget->currentIndex()));
+    if (editor == nullptr || m_searchLineEdit->text().trimmed().isEmpty())
+    {
+        return;
+    }
+
+    // the stored matches may belong to another tab or an older text
+    slotSearchChanged(m_searchLineEdit->text(), true, true);
+    editor->setCarets(m_searchCursors);
+    // the editor keeps plain offsets, live cursors would be updated on
+    // every insert
+    m_searchCursors.clear();
+    m_searchIndex = 0;
+    editor->setFocus();
+}
+
 void Librepad::about()
 {
     QMessageBox::about(this,
@@ -6,8 +6,13 @@
 
 #include <QMainWindow>
 #include <QLineEdit>
+#include <QPointer>
 #include <QCloseEvent>
 #include <QSettings>
+#include <QSharedPointer>
+#include <QTextCursor>
+
+class IdentifierIndex;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -28,6 +33,7 @@ private slots:
     void slotTabClose(int index);
     void newDocument();
     void open();
+    void openAsTable();
     void save();
     void saveAs();
     void reload();
@@ -37,7 +43,11 @@ private slots:
     void copy();
     void paste();
     void setFont();
+    void tableView();
+    void goToLine();
+    void selectAllMatches();
     void about();
+    void applyPendingFont();
 
 protected:
     void closeEvent(QCloseEvent *event) override;
@@ -47,8 +57,14 @@ private:
     QFont m_font;
     Ui::Librepad *ui;
     QLineEdit* m_searchLineEdit;
+    QSharedPointer<IdentifierIndex> m_identifierIndex;
+    QList<QTextCursor> m_searchCursors;
+    int m_searchIndex;
+    QList<QPointer<QWidget>> m_fontPending;
 
     void addNewTab(QString fileName = "");
+    void addViewerTab(QWidget *viewer, const QString &fileName);
+    void applyFont();
     void writeSettings();
     void writeFontSettings();
     void readSettings();
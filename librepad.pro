@@ -3,19 +3,45 @@ TARGET = librepad
 
 QT += widgets
 QT += printsupport
+QT += concurrent
 
 SOURCES += \
     main.cpp \
+    compressedfile.cpp \
+    foldrangetree.cpp \
+    hexviewer.cpp \
+    identifierindex.cpp \
     librepad.cpp \
+    tableviewer.cpp \
     texteditor.cpp
 
 HEADERS += \
+    compressedfile.h \
+    foldrangetree.h \
+    hexviewer.h \
+    identifierindex.h \
     librepad.h \
+    tableviewer.h \
     texteditor.h
 
 
 FORMS += librepad.ui
 
+# optional streaming (de)compression of .gz, .zst and .xz files
+CONFIG += link_pkgconfig
+packagesExist(zlib) {
+    PKGCONFIG += zlib
+    DEFINES += LIBREPAD_HAVE_ZLIB
+}
+packagesExist(libzstd) {
+    PKGCONFIG += libzstd
+    DEFINES += LIBREPAD_HAVE_ZSTD
+}
+packagesExist(liblzma) {
+    PKGCONFIG += liblzma
+    DEFINES += LIBREPAD_HAVE_LZMA
+}
+
 RESOURCES += \
     librepad.qrc
 
@@ -0,0 +1,847 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#include "tableviewer.h"
+
+#include <QByteArrayMatcher>
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTableView>
+#include <QVBoxLayout>
+#include <QVarLengthArray>
+#include <QtConcurrent>
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// bytes handed to one indexing worker, cut at the next line end
+const qint64 IndexChunkSize = 16 * 1024 * 1024;
+// rows handed to one filter worker
+const qint64 FilterChunkRows = 1024 * 1024;
+// whitespace separated logs: the last column takes the rest of the line
+const int LogColumns = 5;
+// header detection only looks at the first line up to this size
+const qint64 MaxHeaderLength = 64 * 1024;
+// cells are cut for display, the index still points to the whole field
+const int MaxDisplayLength = 1024;
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+} // namespace
+
+DelimitedIndex::DelimitedIndex()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_delimiter(',')
+    , m_columns(0)
+    , m_hasHeaderRow(0)
+{
+}
+
+DelimitedIndex::~DelimitedIndex()
+{
+    if (m_data != nullptr)
+    {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    }
+    m_file.close();
+}
+
+bool DelimitedIndex::open(const QString &fileName, QString *errorString)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        *errorString = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size > 0)
+    {
+        m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+        if (m_data == nullptr)
+        {
+            *errorString = m_file.errorString();
+            return false;
+        }
+    }
+
+    detectLayout();
+    return true;
+}
+
+void DelimitedIndex::detectLayout()
+{
+    const char *lineEnd = lineEndAt(0);
+
+    // pick the candidate delimiter seen most often outside of quotes
+    const char candidates[] = { ',', '\t', ';', '|' };
+    int best = 0;
+    for (char candidate : candidates)
+    {
+        int count = 0;
+        bool quoted = false;
+        for (const char *p = m_data; p < lineEnd; p++)
+        {
+            if (*p == '"')
+            {
+                quoted = !quoted;
+            }
+            else if (*p == candidate && !quoted)
+            {
+                count++;
+            }
+        }
+        if (count > best)
+        {
+            best = count;
+            m_delimiter = candidate;
+        }
+    }
+
+    int columns = best + 1;
+    if (best == 0)
+    {
+        // no delimiter, treat it as a whitespace separated log
+        m_delimiter = ' ';
+        QVarLengthArray<const char *, LogColumns> starts(LogColumns);
+        columns = qMax(1, splitRow(m_data, lineEnd, starts.data(), LogColumns));
+    }
+
+    m_columns = columns;
+    m_firstRowNames.clear();
+    QVarLengthArray<const char *, 64> starts(columns);
+    const int found = splitRow(m_data, lineEnd, starts.data(), columns);
+    for (int i = 0; i < columns; i++)
+    {
+        QString name;
+        if (i < found)
+        {
+            const char *end = fieldEnd(starts[i], lineEnd, i == columns - 1);
+            name = QString::fromUtf8(starts[i], int(end - starts[i])).trimmed();
+            if (name.size() >= 2 && name.startsWith('"') && name.endsWith('"'))
+            {
+                name = name.mid(1, name.size() - 2);
+            }
+        }
+        if (name.isEmpty())
+        {
+            name = QObject::tr("Column %1").arg(i + 1);
+        }
+        m_firstRowNames.append(name);
+    }
+
+    // logs start with data, other files when their first line looks like it
+    setHeaderRow(best > 0 && looksLikeHeader(lineEnd, columns));
+}
+
+bool DelimitedIndex::looksLikeHeader(const char *lineEnd, int columns) const
+{
+    QVarLengthArray<const char *, 64> first(columns);
+    const int firstFound = splitRow(m_data, lineEnd, first.data(), columns);
+    for (int i = 0; i < firstFound; i++)
+    {
+        // column names are seldom numbers
+        if (isNumber(first[i], fieldEnd(first[i], lineEnd, false)))
+        {
+            return false;
+        }
+    }
+
+    // no second line, or a first line longer than detection looks at
+    const char *fileEnd = m_data + m_size;
+    const char *second  = lineEnd;
+    while (second < fileEnd && *second == '\r')
+    {
+        second++;
+    }
+    if (second + 1 >= fileEnd || *second != '\n')
+    {
+        return true;
+    }
+    second++;
+
+    // a text field above a number is a column name above its values
+    const char *secondEnd = lineEndAt(second - m_data);
+    QVarLengthArray<const char *, 64> next(columns);
+    const int nextFound = qMin(firstFound, splitRow(second, secondEnd, next.data(), columns));
+    for (int i = 0; i < nextFound; i++)
+    {
+        if (isNumber(next[i], fieldEnd(next[i], secondEnd, false)))
+        {
+            return true;
+        }
+    }
+
+    // all text, column names are at least unique, the viewer lets the
+    // user switch when this guesses wrong
+    QSet<QByteArray> names;
+    for (int i = 0; i < firstFound; i++)
+    {
+        const QByteArray name(first[i], int(fieldEnd(first[i], lineEnd, false) - first[i]));
+        if (names.contains(name))
+        {
+            return false;
+        }
+        names.insert(name);
+    }
+    return true;
+}
+
+bool DelimitedIndex::isNumber(const char *begin, const char *end) const
+{
+    while (begin < end && isBlank(*begin))
+    {
+        begin++;
+    }
+    while (end > begin && isBlank(end[-1]))
+    {
+        end--;
+    }
+    if (end - begin >= 2 && *begin == '"' && end[-1] == '"')
+    {
+        begin++;
+        end--;
+    }
+    if (begin == end)
+    {
+        return false;
+    }
+
+    bool ok;
+    QByteArray::fromRawData(begin, int(end - begin)).toDouble(&ok);
+    return ok;
+}
+
+const char *DelimitedIndex::lineEndAt(qint64 pos) const
+{
+    if (m_data == nullptr)
+    {
+        return nullptr;
+    }
+
+    const char *begin   = m_data + pos;
+    const qint64 length = qMin(m_size - pos, MaxHeaderLength);
+    const char *newline = static_cast<const char *>(memchr(begin, '\n', length));
+    const char *end     = newline ? newline : begin + length;
+    if (end > begin && end[-1] == '\r')
+    {
+        end--;
+    }
+    return end;
+}
+
+void DelimitedIndex::setHeaderRow(bool headerRow)
+{
+    m_hasHeaderRow.storeRelease(headerRow ? 1 : 0);
+    m_headers.clear();
+    for (int i = 0; i < m_firstRowNames.size(); i++)
+    {
+        m_headers.append(headerRow ? m_firstRowNames.at(i) : QObject::tr("Column %1").arg(i + 1));
+    }
+}
+
+void DelimitedIndex::build()
+{
+    if (m_data == nullptr)
+    {
+        return;
+    }
+
+    // every line is indexed, the header row is skipped on access, so
+    // switching it needs no rebuild
+    QVector<Chunk> chunks;
+    qint64 pos = 0;
+    while (pos < m_size)
+    {
+        qint64 end = qMin(pos + IndexChunkSize, m_size);
+        if (end < m_size)
+        {
+            const char *newline = static_cast<const char *>(memchr(m_data + end, '\n', m_size - end));
+            end = newline ? newline - m_data + 1 : m_size;
+        }
+
+        Chunk chunk;
+        chunk.begin    = pos;
+        chunk.end      = end;
+        chunk.rows     = 0;
+        chunk.firstRow = 0;
+        chunks.append(chunk);
+        pos = end;
+    }
+
+    // count first, so the index is allocated once at its final size and
+    // the workers write their rows in place
+    QtConcurrent::blockingMap(chunks, [this](Chunk &chunk) { chunk.rows = countRows(chunk); });
+
+    qint64 rows = 0;
+    for (Chunk &chunk : chunks)
+    {
+        chunk.firstRow = rows;
+        rows += chunk.rows;
+    }
+
+    m_rowOffsets = QVector<qint64>(int(rows + 1));
+    m_fieldOffsets = QVector<QVector<quint16>>(columnCount());
+    QVector<quint16 *> columns;
+    for (QVector<quint16> &column : m_fieldOffsets)
+    {
+        column.resize(int(rows));
+        columns.append(column.data());
+    }
+    qint64 *rowOffsets = m_rowOffsets.data();
+
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) { indexChunk(chunk, rowOffsets, columns.constData()); });
+    rowOffsets[rows] = m_size;
+}
+
+qint64 DelimitedIndex::countRows(const Chunk &chunk) const
+{
+    qint64 rows = 0;
+    const char *p   = m_data + chunk.begin;
+    const char *end = m_data + chunk.end;
+    while (p < end)
+    {
+        const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (newline == nullptr)
+        {
+            // last line without a line end
+            return rows + 1;
+        }
+        rows++;
+        p = newline + 1;
+    }
+    return rows;
+}
+
+void DelimitedIndex::indexChunk(const Chunk &chunk, qint64 *rowOffsets, quint16 *const *fieldOffsets) const
+{
+    const int columns = columnCount();
+    QVarLengthArray<const char *, 64> starts(columns);
+
+    qint64 row      = chunk.firstRow;
+    const char *p   = m_data + chunk.begin;
+    const char *end = m_data + chunk.end;
+    while (p < end)
+    {
+        const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+        const char *next    = newline ? newline + 1 : end;
+        const char *lineEnd = newline ? newline : end;
+        if (lineEnd > p && lineEnd[-1] == '\r')
+        {
+            lineEnd--;
+        }
+
+        rowOffsets[row] = p - m_data;
+        const int found = splitRow(p, lineEnd, starts.data(), columns);
+        for (int column = 0; column < columns; column++)
+        {
+            quint16 offset = FieldMissing;
+            if (column < found)
+            {
+                const qint64 relative = starts[column] - p;
+                offset = relative < FieldOverflow ? quint16(relative) : FieldOverflow;
+            }
+            fieldOffsets[column][row] = offset;
+        }
+        row++;
+        p = next;
+    }
+}
+
+int DelimitedIndex::splitRow(const char *begin, const char *end, const char **starts, int max) const
+{
+    int count = 0;
+    const char *p = begin;
+
+    if (m_delimiter == ' ')
+    {
+        while (p < end && isBlank(*p))
+        {
+            p++;
+        }
+        while (p < end && count < max)
+        {
+            starts[count++] = p;
+            p = fieldEnd(p, end, false);
+            while (p < end && isBlank(*p))
+            {
+                p++;
+            }
+        }
+        return count;
+    }
+
+    while (count < max)
+    {
+        starts[count++] = p;
+        const char *fieldStop = fieldEnd(p, end, false);
+        if (fieldStop >= end)
+        {
+            break;
+        }
+        p = fieldStop + 1;
+    }
+    return count;
+}
+
+const char *DelimitedIndex::fieldEnd(const char *begin, const char *rowEnd, bool last) const
+{
+    if (m_delimiter == ' ')
+    {
+        if (last)
+        {
+            return rowEnd;
+        }
+        const char *p = begin;
+        while (p < rowEnd && !isBlank(*p))
+        {
+            p++;
+        }
+        return p;
+    }
+
+    const char *p = begin;
+    if (p < rowEnd && *p == '"')
+    {
+        // skip the quoted part, a doubled quote is an escaped one
+        p++;
+        while (p < rowEnd)
+        {
+            const char *quote = static_cast<const char *>(memchr(p, '"', rowEnd - p));
+            if (quote == nullptr)
+            {
+                return rowEnd;
+            }
+            p = quote + 1;
+            if (p < rowEnd && *p == '"')
+            {
+                p++;
+                continue;
+            }
+            break;
+        }
+    }
+
+    const char *delimiter = static_cast<const char *>(memchr(p, m_delimiter, rowEnd - p));
+    return delimiter ? delimiter : rowEnd;
+}
+
+const char *DelimitedIndex::rowEnd(qint64 row) const
+{
+    const char *begin = m_data + m_rowOffsets.at(row);
+    const char *end   = m_data + m_rowOffsets.at(row + 1);
+    if (end > begin && end[-1] == '\n')
+    {
+        end--;
+    }
+    if (end > begin && end[-1] == '\r')
+    {
+        end--;
+    }
+    return end;
+}
+
+const char *DelimitedIndex::field(qint64 row, int column, int *length) const
+{
+    *length = 0;
+    const qint64 lines = m_rowOffsets.size() - 1;
+    row += m_hasHeaderRow.loadAcquire();
+    if (row < 0 || row >= lines || column < 0 || column >= columnCount())
+    {
+        return nullptr;
+    }
+
+    const quint16 offset = m_fieldOffsets.at(column).at(row);
+    if (offset == FieldMissing)
+    {
+        return nullptr;
+    }
+
+    const char *begin = m_data + m_rowOffsets.at(row);
+    const char *end   = rowEnd(row);
+    const char *start = begin + offset;
+    if (offset == FieldOverflow)
+    {
+        // field starts too far into its row for the compact index
+        QVarLengthArray<const char *, 64> starts(columnCount());
+        splitRow(begin, end, starts.data(), columnCount());
+        start = starts[column];
+    }
+
+    const char *stop = fieldEnd(start, end, column == columnCount() - 1);
+    if (m_delimiter != ' ' && stop - start >= 2 && *start == '"' && stop[-1] == '"')
+    {
+        start++;
+        stop--;
+    }
+    *length = int(stop - start);
+    return start;
+}
+
+int DelimitedIndex::columnForName(const QString &name) const
+{
+    for (int i = 0; i < m_headers.size(); i++)
+    {
+        if (m_headers.at(i).compare(name, Qt::CaseInsensitive) == 0)
+        {
+            return i;
+        }
+    }
+
+    QString number = name;
+    if (number.startsWith('$'))
+    {
+        number.remove(0, 1);
+    }
+    bool ok;
+    const int column = number.toInt(&ok) - 1;
+    if (ok && column >= 0 && column < columnCount())
+    {
+        return column;
+    }
+    return -1;
+}
+
+DelimitedTableModel::DelimitedTableModel(QSharedPointer<DelimitedIndex> index, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_index(index)
+    , m_filtered(false)
+    , m_filterPending(false)
+{
+    connect(&m_filterWatcher, &QFutureWatcherBase::finished, this, [=]() {
+        if (!m_filterPending)
+        {
+            return;
+        }
+        m_filterPending = false;
+        beginResetModel();
+        m_rows     = m_filterWatcher.result();
+        m_filtered = true;
+        endResetModel();
+        emit filterFinished();
+    });
+}
+
+int DelimitedTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return int(qMin<qint64>(matchCount(), std::numeric_limits<int>::max()));
+}
+
+int DelimitedTableModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return m_index->columnCount();
+}
+
+QVariant DelimitedTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    int length;
+    const char *field = m_index->field(sourceRow(index.row()), index.column(), &length);
+    if (field == nullptr)
+    {
+        return QVariant();
+    }
+    return QString::fromUtf8(field, qMin(length, MaxDisplayLength));
+}
+
+QVariant DelimitedTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Horizontal)
+    {
+        return m_index->headers().value(section);
+    }
+
+    // line number in the file
+    return sourceRow(section) + (m_index->hasHeaderRow() ? 2 : 1);
+}
+
+void DelimitedTableModel::reset()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_filtered = false;
+    endResetModel();
+}
+
+void DelimitedTableModel::setHeaderRow(bool headerRow)
+{
+    // rows of a running filter are counted the old way, drop them
+    beginResetModel();
+    m_filterPending = false;
+    m_index->setHeaderRow(headerRow);
+    m_rows.clear();
+    m_filtered = false;
+    endResetModel();
+}
+
+bool DelimitedTableModel::setFilter(const QString &expression, QString *errorString)
+{
+    if (expression.trimmed().isEmpty())
+    {
+        m_filterPending = false;
+        reset();
+        emit filterFinished();
+        return true;
+    }
+
+    static const QRegularExpression conditionPattern("^\\s*(\\S+?)\\s*(==|!=|~=)\\s*(.*?)\\s*$");
+
+    QVector<Condition> conditions;
+    const QStringList parts = expression.split("&&");
+    for (const QString &part : parts)
+    {
+        QRegularExpressionMatch match = conditionPattern.match(part);
+        if (!match.hasMatch())
+        {
+            *errorString = tr("invalid filter: ") + part.trimmed();
+            return false;
+        }
+
+        Condition condition;
+        condition.column = m_index->columnForName(match.captured(1));
+        if (condition.column < 0)
+        {
+            *errorString = tr("unknown column: ") + match.captured(1);
+            return false;
+        }
+
+        const QString op = match.captured(2);
+        condition.op = op == "==" ? Condition::Equal : op == "!=" ? Condition::NotEqual : Condition::Contains;
+
+        QString value = match.captured(3);
+        if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"'))
+        {
+            value = value.mid(1, value.size() - 2);
+        }
+        condition.value = value.toUtf8();
+        conditions.append(condition);
+    }
+
+    QSharedPointer<DelimitedIndex> index = m_index;
+    m_filterPending = true;
+    m_filterWatcher.setFuture(QtConcurrent::run([index, conditions]() {
+        return scan(index, conditions);
+    }));
+    return true;
+}
+
+QVector<qint64> DelimitedTableModel::scan(QSharedPointer<DelimitedIndex> index, const QVector<Condition> &conditions)
+{
+    struct Range
+    {
+        qint64 begin;
+        qint64 end;
+        QVector<qint64> rows;
+    };
+
+    QVector<QByteArrayMatcher> matchers;
+    for (const Condition &condition : conditions)
+    {
+        matchers.append(QByteArrayMatcher(condition.value));
+    }
+
+    QVector<Range> ranges;
+    for (qint64 row = 0; row < index->rowCount(); row += FilterChunkRows)
+    {
+        Range range;
+        range.begin = row;
+        range.end   = qMin(row + FilterChunkRows, index->rowCount());
+        ranges.append(range);
+    }
+
+    // each worker walks its rows column by column through the offset index
+    QtConcurrent::blockingMap(ranges, [&](Range &range) {
+        for (qint64 row = range.begin; row < range.end; row++)
+        {
+            bool accepted = true;
+            for (int i = 0; i < conditions.size() && accepted; i++)
+            {
+                const Condition &condition = conditions.at(i);
+                int length;
+                const char *field = index->field(row, condition.column, &length);
+                const int valueLength = condition.value.size();
+                switch (condition.op)
+                {
+                case Condition::Equal:
+                    accepted = length == valueLength && (length == 0 || memcmp(field, condition.value.constData(), length) == 0);
+                    break;
+                case Condition::NotEqual:
+                    accepted = length != valueLength || (length > 0 && memcmp(field, condition.value.constData(), length) != 0);
+                    break;
+                case Condition::Contains:
+                    accepted = valueLength == 0 || (field != nullptr && matchers.at(i).indexIn(field, length) >= 0);
+                    break;
+                }
+            }
+            if (accepted)
+            {
+                range.rows.append(row);
+            }
+        }
+    });
+
+    QVector<qint64> rows;
+    for (Range &range : ranges)
+    {
+        rows += range.rows;
+        range.rows = QVector<qint64>();
+    }
+    return rows;
+}
+
+TableViewer::TableViewer(QWidget *parent, const QString& fileName)
+    : QWidget(parent)
+    , m_fileName(fileName)
+    , m_index(new DelimitedIndex)
+    , m_model(nullptr)
+    , m_tableView(new QTableView)
+    , m_filterLineEdit(new QLineEdit)
+    , m_headerCheckBox(new QCheckBox(tr("First row is header")))
+    , m_statusLabel(new QLabel)
+{
+    m_filterLineEdit->setPlaceholderText(tr("Filter, e.g. level == ERROR && message ~= timeout"));
+    m_filterLineEdit->setEnabled(false);
+    m_headerCheckBox->setEnabled(false);
+
+    // rows are never measured, millions of them stay cheap to scroll
+    m_tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    updateRowHeight();
+    m_tableView->horizontalHeader()->setStretchLastSection(true);
+    m_tableView->setWordWrap(false);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    QHBoxLayout *filterLayout = new QHBoxLayout;
+    filterLayout->addWidget(m_filterLineEdit);
+    filterLayout->addWidget(m_headerCheckBox);
+    layout->addLayout(filterLayout);
+    layout->addWidget(m_tableView);
+    layout->addWidget(m_statusLabel);
+
+    connect(m_filterLineEdit, &QLineEdit::returnPressed, this, &TableViewer::applyFilter);
+    connect(m_headerCheckBox, &QCheckBox::toggled, this, &TableViewer::setHeaderRow);
+    connect(&m_indexWatcher, &QFutureWatcherBase::finished, this, &TableViewer::indexFinished);
+
+    QString errorString;
+    if (!m_index->open(m_fileName, &errorString))
+    {
+        QMessageBox::critical(this, tr("Critical"), tr("Cannot read file: ") + errorString);
+        m_statusLabel->setText(tr("Cannot read file"));
+        return;
+    }
+
+    m_statusLabel->setText(tr("Indexing..."));
+    QSharedPointer<DelimitedIndex> index = m_index;
+    m_indexWatcher.setFuture(QtConcurrent::run([index]() { index->build(); }));
+}
+
+TableViewer::~TableViewer()
+{
+    // running workers keep their own reference to the index
+    m_tableView->setModel(nullptr);
+}
+
+void TableViewer::indexFinished()
+{
+    m_model = new DelimitedTableModel(m_index, this);
+    connect(m_model, &DelimitedTableModel::filterFinished, this, &TableViewer::filterFinished);
+    m_tableView->setModel(m_model);
+    m_filterLineEdit->setEnabled(true);
+    m_headerCheckBox->setChecked(m_index->hasHeaderRow());
+    m_headerCheckBox->setEnabled(true);
+    updateStatus();
+}
+
+void TableViewer::setHeaderRow(bool headerRow)
+{
+    if (m_model == nullptr || headerRow == m_index->hasHeaderRow())
+    {
+        return;
+    }
+
+    // the index holds every line, only the model has to start over
+    m_model->setHeaderRow(headerRow);
+    if (m_filterLineEdit->text().trimmed().isEmpty())
+    {
+        updateStatus();
+        return;
+    }
+    applyFilter();
+}
+
+void TableViewer::applyFilter()
+{
+    if (m_model == nullptr)
+    {
+        return;
+    }
+
+    QString errorString;
+    if (!m_model->setFilter(m_filterLineEdit->text(), &errorString))
+    {
+        m_statusLabel->setText(errorString);
+        return;
+    }
+    m_statusLabel->setText(tr("Filtering..."));
+}
+
+void TableViewer::filterFinished()
+{
+    updateStatus();
+}
+
+void TableViewer::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::FontChange)
+    {
+        updateRowHeight();
+    }
+}
+
+void TableViewer::updateRowHeight()
+{
+    m_tableView->verticalHeader()->setDefaultSectionSize(m_tableView->fontMetrics().height() + 4);
+}
+
+void TableViewer::updateStatus()
+{
+    if (m_model->isFiltered())
+    {
+        m_statusLabel->setText(tr("%1 of %2 rows").arg(m_model->matchCount()).arg(m_index->rowCount()));
+    }
+    else
+    {
+        m_statusLabel->setText(tr("%1 rows").arg(m_index->rowCount()));
+    }
+}
@@ -0,0 +1,158 @@
+// Copyright (C) 2024 Emanuel Strobel
+// GPLv2
+
+#ifndef TABLEVIEWER_H
+#define TABLEVIEWER_H
+
+#include <QAbstractTableModel>
+#include <QAtomicInt>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+#include <QWidget>
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QTableView;
+
+/*
+ * Row and field offset index over a memory-mapped delimited file.
+ *
+ * Rows are stored as absolute byte offsets, fields column by column as
+ * 16 bit offsets relative to their row start, so a column can be scanned
+ * without touching the others and the file is never decoded as a whole.
+ */
+class DelimitedIndex
+{
+public:
+    DelimitedIndex();
+    ~DelimitedIndex();
+
+    bool open(const QString &fileName, QString *errorString);
+    void build();
+
+    qint64 rowCount() const { return qMax<qint64>(0, m_rowOffsets.size() - 1 - m_hasHeaderRow.loadAcquire()); }
+    int columnCount() const { return m_columns; }
+    QStringList headers() const { return m_headers; }
+    bool hasHeaderRow() const { return m_hasHeaderRow.loadAcquire() != 0; }
+    void setHeaderRow(bool headerRow);
+
+    const char *field(qint64 row, int column, int *length) const;
+    int columnForName(const QString &name) const;
+
+private:
+    struct Chunk
+    {
+        qint64 begin;
+        qint64 end;
+        qint64 rows;
+        qint64 firstRow;
+    };
+
+    static constexpr quint16 FieldMissing  = 0xffff;
+    static constexpr quint16 FieldOverflow = 0xfffe;
+
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    char m_delimiter;
+    int m_columns;
+    // read by filter workers while the viewer may switch it
+    QAtomicInt m_hasHeaderRow;
+    QStringList m_firstRowNames;
+    QStringList m_headers;
+    QVector<qint64> m_rowOffsets;
+    QVector<QVector<quint16>> m_fieldOffsets;
+
+    void detectLayout();
+    bool looksLikeHeader(const char *lineEnd, int columns) const;
+    bool isNumber(const char *begin, const char *end) const;
+    const char *lineEndAt(qint64 pos) const;
+    qint64 countRows(const Chunk &chunk) const;
+    void indexChunk(const Chunk &chunk, qint64 *rowOffsets, quint16 *const *fieldOffsets) const;
+    int splitRow(const char *begin, const char *end, const char **starts, int max) const;
+    const char *fieldEnd(const char *begin, const char *rowEnd, bool last) const;
+    const char *rowEnd(qint64 row) const;
+};
+
+class DelimitedTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    DelimitedTableModel(QSharedPointer<DelimitedIndex> index, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void reset();
+    void setHeaderRow(bool headerRow);
+    bool setFilter(const QString &expression, QString *errorString);
+    bool isFiltered() const { return m_filtered; }
+    qint64 matchCount() const { return m_filtered ? m_rows.size() : m_index->rowCount(); }
+
+signals:
+    void filterFinished();
+
+private:
+    struct Condition
+    {
+        int column;
+        enum Op { Equal, NotEqual, Contains } op;
+        QByteArray value;
+    };
+
+    QSharedPointer<DelimitedIndex> m_index;
+    QVector<qint64> m_rows;
+    bool m_filtered;
+    bool m_filterPending;
+    QFutureWatcher<QVector<qint64>> m_filterWatcher;
+
+    qint64 sourceRow(int row) const { return m_filtered ? m_rows.at(row) : row; }
+    static QVector<qint64> scan(QSharedPointer<DelimitedIndex> index, const QVector<Condition> &conditions);
+};
+
+class TableViewer : public QWidget
+{
+    Q_OBJECT
+public:
+    TableViewer(QWidget *parent, const QString& fileName);
+    ~TableViewer();
+
+    QString path() const { return m_fileName; }
+
+    QString fileName() const
+    {
+        QFileInfo info(m_fileName);
+        return info.fileName();
+    }
+
+protected:
+    void changeEvent(QEvent *event) override;
+
+private slots:
+    void indexFinished();
+    void setHeaderRow(bool headerRow);
+    void applyFilter();
+    void filterFinished();
+
+private:
+    QString m_fileName;
+    QSharedPointer<DelimitedIndex> m_index;
+    DelimitedTableModel *m_model;
+    QTableView *m_tableView;
+    QLineEdit *m_filterLineEdit;
+    QCheckBox *m_headerCheckBox;
+    QLabel *m_statusLabel;
+    QFutureWatcher<void> m_indexWatcher;
+
+    void updateStatus();
+    void updateRowHeight();
+};
+
+#endif   // TABLEVIEWER_H
@@ -3,35 +3,225 @@
 
 #include "texteditor.h"
 
+#include <QAbstractItemView>
 #include <QApplication>
+#include <QCache>
+#include <QCompleter>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QKeyEvent>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QMouseEvent>
 #include <QPainter>
 #include <QTextBlock>
 #include <QtPrintSupport/qtprintsupportglobal.h>
 #include <QPrintDialog>
 #include <QPrinter>
 #include <QDir>
+#include <QScrollBar>
+#include <QStaticText>
+#include <QStringListModel>
+#include <QTimer>
 
-TextEditor::TextEditor(QWidget *parent, const QString& fileName)
+#include <algorithm>
+
+// identifier hashes of deleted blocks, collected until the next index update
+struct TokenJournal
+{
+    QVector<IdentifierIndex::WordHash> removed;
+};
+
+namespace {
+
+const int MaxCompletions = 50;
+const int MinCompletionPrefix = 3;
+const int MaxLineNumberTexts = 4096;
+
+// shaped line numbers, shared by the gutters of all editors
+QStaticText lineNumberText(int number, const QFont &font)
+{
+    static QCache<int, QStaticText> cache(MaxLineNumberTexts);
+    static QString fontKey;
+    // the prepared texts hold font data, release them while the
+    // application is still there
+    static const QMetaObject::Connection release = QObject::connect(qApp, &QCoreApplication::aboutToQuit, []() {
+        cache.clear();
+        fontKey.clear();
+    });
+    Q_UNUSED(release)
+    if (font.key() != fontKey)
+    {
+        cache.clear();
+        fontKey = font.key();
+    }
+
+    QStaticText *text = cache.object(number);
+    if (text == nullptr)
+    {
+        text = new QStaticText(QString::number(number));
+        text->setTextFormat(Qt::PlainText);
+        text->prepare(QTransform(), font);
+        cache.insert(number, text);
+    }
+    return *text;
+}
+
+class BlockTokens : public QTextBlockUserData
+{
+public:
+    BlockTokens(QSharedPointer<TokenJournal> journal)
+        : m_journal(journal)
+    {
+    }
+
+    ~BlockTokens() override
+    {
+        m_journal->removed += hashes;
+    }
+
+    // hashes only, the words themselves live in the shared index
+    QVector<IdentifierIndex::WordHash> hashes;
+
+private:
+    QSharedPointer<TokenJournal> m_journal;
+};
+
+// block user state: bracket depth at the end of the block in the low and
+// the lowest depth reached inside the block in the high 16 bits
+const int MaxBracketDepth = 0x7fff;
+
+int endDepth(int state)
+{
+    return state < 0 ? 0 : state & 0xffff;
+}
+
+int minDepth(int state)
+{
+    return state < 0 ? 0 : state >> 16;
+}
+
+int bracketState(const QString &text, int depth)
+{
+    int lowest = depth;
+    for (const QChar c : text)
+    {
+        switch (c.unicode())
+        {
+        case '{':
+        case '(':
+        case '[':
+            depth = qMin(depth + 1, MaxBracketDepth);
+            break;
+        case '}':
+        case ')':
+        case ']':
+            depth  = qMax(depth - 1, 0);
+            lowest = qMin(lowest, depth);
+            break;
+        default:
+            break;
+        }
+    }
+    return (lowest << 16) | depth;
+}
+
+// -1 for blank lines, they never open or close an indentation fold
+int indentation(const QString &text)
+{
+    int width = 0;
+    for (const QChar c : text)
+    {
+        if (c == ' ')
+        {
+            width++;
+        }
+        else if (c == '\t')
+        {
+            width += 4;
+        }
+        else
+        {
+            return width;
+        }
+    }
+    return -1;
+}
+
+bool startsWithCloser(const QString &text)
+{
+    const QString trimmed = text.trimmed();
+    return trimmed.startsWith('}') || trimmed.startsWith(')') || trimmed.startsWith(']');
+}
+
+} // namespace
+
+TextEditor::TextEditor(QWidget *parent, const QString& fileName, const QFont &font)
     : QPlainTextEdit(parent)
     , m_lineNumberWidget(new LineNumberWidget(this))
     , m_fileName(fileName)
     , m_firstSave(false)
+    , m_foldBlockCount(1)
+    , m_updatingFolds(false)
+    , m_compression(CompressedFile::None)
+    , m_loader(nullptr)
+    , m_tokenJournal(new TokenJournal)
+    , m_indexPending(false)
+    , m_indexRevision(0)
+    , m_completer(new QCompleter(this))
+    , m_completionModel(new QStringListModel(this))
+    , m_editingCarets(false)
+    , m_columnSelecting(false)
+    , m_columnAnchorBlock(0)
+    , m_columnAnchorColumn(0)
 {
+    // set before the text is loaded, so it is not laid out twice
+    setFont(font);
     setViewportMargins(25, 0, 0, 0);
     highlightCurrentLine();
 
     connect(this, &QPlainTextEdit::updateRequest, this, &TextEditor::updateLineNumber);
     connect(this, &QPlainTextEdit::cursorPositionChanged, this, &TextEditor::highlightCurrentLine);
     connect(this, &QPlainTextEdit::blockCountChanged, this, &TextEditor::updateLineNumberMargin);
+    connect(document(), &QTextDocument::contentsChange, this, &TextEditor::updateFolding);
+    connect(document(), &QTextDocument::contentsChange, this, &TextEditor::updateIdentifiers);
+    connect(&m_indexWatcher, &QFutureWatcherBase::finished, this, &TextEditor::documentIndexed);
+    connect(document(), &QTextDocument::contentsChange, this, [=]() {
+        // other edits move the text under the carets
+        if (!m_editingCarets && !m_updatingFolds)
+        {
+            clearCarets();
+        }
+    });
+
+    m_completer->setModel(m_completionModel);
+    m_completer->setWidget(this);
+    m_completer->setCompletionMode(QCompleter::PopupCompletion);
+    m_completer->setCaseSensitivity(Qt::CaseSensitive);
+    connect(m_completer, QOverload<const QString &>::of(&QCompleter::activated), this, &TextEditor::insertCompletion);
 
     load(m_fileName);
 }
 
 TextEditor::~TextEditor()
 {
+    // the shared index forgets the words of this document
+    if (!m_identifierIndex.isNull())
+    {
+        QVector<IdentifierIndex::WordHash> removed;
+        for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
+        {
+            BlockTokens *data = static_cast<BlockTokens *>(block.userData());
+            if (data != nullptr)
+            {
+                removed += data->hashes;
+                data->hashes.clear();
+            }
+        }
+        m_identifierIndex->update(removed + m_tokenJournal->removed, QStringList());
+        m_tokenJournal->removed.clear();
+    }
+
     delete m_lineNumberWidget;
     m_lineNumberWidget = nullptr;
 }
@@ -48,8 +238,24 @@ void TextEditor::lineNumberPaintEvent(QPaintEvent *e)
 
     // qDebug() << "start " << top;
 
+    const int markerWidth = foldMarkerWidth();
+    const int markerLeft  = getLineNumberWidth() - markerWidth;
+
+    QFont font = painter.font();
+    font.setPointSize(9);
+    painter.setFont(font);
+
     while (block.isValid() && top <= e->rect().bottom())
     {
+        // folded blocks have no height, nothing to paint
+        if (!block.isVisible())
+        {
+            block  = block.next();
+            top    = bottom;
+            bottom = top + blockBoundingGeometry(block).height();
+            continue;
+        }
+
         int lineNumber = block.blockNumber();
         int lineHeight = blockBoundingGeometry(block).height();
         if (!block.next().isValid())
@@ -58,23 +264,885 @@ void TextEditor::lineNumberPaintEvent(QPaintEvent *e)
         }
 
         // qDebug() << "lineNumbe" << lineNumber << "top " << top << "bottom " << bottom;
-        QRect rect(0, top, getLineNumberWidth() - 2, lineHeight);
-        QFont font = painter.font();
-        font.setPointSize(9);
-        painter.setFont(font);
-        painter.drawText(rect, Qt::AlignLeft | Qt::AlignVCenter, QString::number(lineNumber + 1));
+        const QStaticText text = lineNumberText(lineNumber + 1, font);
+        painter.drawStaticText(0, top + (lineHeight - qRound(text.size().height())) / 2, text);
 
+        FoldRangeTree::Range range;
+        const bool folded = m_folds.find(lineNumber, &range);
+        if (folded || isFoldable(block))
+        {
+            const int size = markerWidth / 2;
+            const int x    = markerLeft + (markerWidth - size) / 2;
+            const int y    = top + (lineHeight - size) / 2;
+            QPolygon marker;
+            if (folded)
+            {
+                marker << QPoint(x, y) << QPoint(x + size, y + size / 2) << QPoint(x, y + size);
+            }
+            else
+            {
+                marker << QPoint(x, y) << QPoint(x + size, y) << QPoint(x + size / 2, y + size);
+            }
+            painter.save();
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setBrush(folded ? QColor(80, 80, 80) : QColor(150, 150, 150));
+            painter.setPen(Qt::NoPen);
+            painter.drawPolygon(marker);
+            painter.restore();
+        }
+
+        block  = block.next();
+        top    = bottom;
+        bottom = top + blockBoundingGeometry(block).height();
+    }
+}
+
+void TextEditor::lineNumberMousePressEvent(QMouseEvent *e)
+{
+    if (e->pos().x() < getLineNumberWidth() - foldMarkerWidth())
+    {
+        return;
+    }
+
+    QTextBlock block = firstVisibleBlock();
+    int top    = blockBoundingGeometry(block).translated(contentOffset()).top() + 1;
+    int bottom = top + blockBoundingGeometry(block).height();
+
+    while (block.isValid() && top <= e->pos().y())
+    {
+        if (block.isVisible() && e->pos().y() < bottom)
+        {
+            toggleFold(block);
+            return;
+        }
         block  = block.next();
         top    = bottom;
         bottom = top + blockBoundingGeometry(block).height();
     }
 }
 
+void TextEditor::toggleFold(const QTextBlock &block)
+{
+    const int number = block.blockNumber();
+
+    FoldRangeTree::Range range;
+    if (m_folds.find(number, &range))
+    {
+        m_folds.remove(number);
+        showBlocks(range.start + 1, range.end);
+        relayoutBlocks(range.start, range.end);
+        return;
+    }
+
+    int end;
+    if (!foldRange(block, &end))
+    {
+        return;
+    }
+    m_folds.insert(number, end);
+
+    QTextBlock hidden = block.next();
+    while (hidden.isValid() && hidden.blockNumber() <= end)
+    {
+        hidden.setVisible(false);
+        hidden = hidden.next();
+    }
+
+    // keep the cursor out of the folded blocks
+    const int cursorBlock = textCursor().blockNumber();
+    if (cursorBlock > number && cursorBlock <= end)
+    {
+        QTextCursor cursor(block);
+        cursor.movePosition(QTextCursor::EndOfBlock);
+        setTextCursor(cursor);
+    }
+    relayoutBlocks(number, end);
+}
+
+bool TextEditor::isFoldable(const QTextBlock &block) const
+{
+    const int state = block.userState();
+    if (endDepth(state) > minDepth(state))
+    {
+        return true;
+    }
+
+    const int indent = indentation(block.text());
+    if (indent < 0)
+    {
+        return false;
+    }
+    for (QTextBlock next = block.next(); next.isValid(); next = next.next())
+    {
+        const int nextIndent = indentation(next.text());
+        if (nextIndent >= 0)
+        {
+            return nextIndent > indent;
+        }
+    }
+    return false;
+}
+
+bool TextEditor::foldRange(const QTextBlock &block, int *end) const
+{
+    const int number = block.blockNumber();
+    const int state  = block.userState();
+    const int base   = minDepth(state);
+
+    if (endDepth(state) > base)
+    {
+        // brackets: up to the block closing back below the opening depth
+        QTextBlock next = block.next();
+        while (next.isValid() && minDepth(next.userState()) > base)
+        {
+            next = next.next();
+        }
+        if (!next.isValid())
+        {
+            *end = blockCount() - 1;
+        }
+        else
+        {
+            *end = next.blockNumber();
+            if (startsWithCloser(next.text()))
+            {
+                *end -= 1;
+            }
+        }
+        return *end > number;
+    }
+
+    // indentation: every following block indented deeper, blank lines
+    // at the end stay visible
+    const int indent = indentation(block.text());
+    if (indent < 0)
+    {
+        return false;
+    }
+    *end = -1;
+    for (QTextBlock next = block.next(); next.isValid(); next = next.next())
+    {
+        const int nextIndent = indentation(next.text());
+        if (nextIndent < 0)
+        {
+            continue;
+        }
+        if (nextIndent <= indent)
+        {
+            break;
+        }
+        *end = next.blockNumber();
+    }
+    return *end > number;
+}
+
+void TextEditor::showBlocks(int first, int last)
+{
+    // folded ranges nested inside stay folded
+    const QVector<FoldRangeTree::Range> nested = m_folds.overlapping(first, last);
+    int i = 0;
+
+    QTextBlock block = document()->findBlockByNumber(first);
+    while (block.isValid() && block.blockNumber() <= last)
+    {
+        block.setVisible(true);
+
+        const int number = block.blockNumber();
+        while (i < nested.size() && nested.at(i).start < number)
+        {
+            i++;
+        }
+        if (i < nested.size() && nested.at(i).start == number)
+        {
+            block = document()->findBlockByNumber(nested.at(i).end + 1);
+            continue;
+        }
+        block = block.next();
+    }
+}
+
+void TextEditor::relayoutBlocks(int first, int last)
+{
+    QTextBlock from = document()->findBlockByNumber(first);
+    QTextBlock to   = document()->findBlockByNumber(last);
+    if (!from.isValid())
+    {
+        return;
+    }
+    if (!to.isValid())
+    {
+        to = document()->lastBlock();
+    }
+
+    // only the changed blocks are laid out again
+    m_updatingFolds = true;
+    document()->markContentsDirty(from.position(), to.position() + to.length() - from.position());
+    m_updatingFolds = false;
+
+    viewport()->update();
+    m_lineNumberWidget->update();
+}
+
+void TextEditor::updateFolding(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (m_updatingFolds || m_editingCarets)
+    {
+        return;
+    }
+
+    const int blocks = blockCount();
+    const int delta  = blocks - m_foldBlockCount;
+    m_foldBlockCount = blocks;
+
+    QTextBlock first = document()->findBlock(position);
+    QTextBlock last  = document()->findBlock(position + charsAdded);
+    if (!first.isValid())
+    {
+        first = document()->lastBlock();
+    }
+    if (!last.isValid())
+    {
+        last = document()->lastBlock();
+    }
+    refoldBlocks(first.blockNumber(), last.blockNumber(), delta);
+}
+
+void TextEditor::clearFolds()
+{
+    // the old folds mean nothing in a new text; the blocks they hid go away
+    // with it
+    m_folds.clear();
+    m_foldBlockCount = blockCount();
+}
+
+void TextEditor::refoldBlocks(int firstNumber, int lastNumber, int delta)
+{
+    const int oldLast = lastNumber - delta;
+
+    // folds whose hidden blocks are edited are opened, the others move
+    // with the text; an edit of the header line keeps the fold on the
+    // line that now precedes its hidden blocks
+    if (!m_folds.isEmpty())
+    {
+        const QVector<FoldRangeTree::Range> touched = m_folds.takeOverlapping(firstNumber, oldLast);
+        m_folds.shift(oldLast + 1, delta);
+        for (const FoldRangeTree::Range &range : touched)
+        {
+            if (range.start == oldLast)
+            {
+                m_folds.insert(lastNumber, range.end + delta);
+                continue;
+            }
+            const int from = qMin(range.start + 1, firstNumber);
+            const int to   = range.end > oldLast ? range.end + delta : lastNumber;
+            showBlocks(from, to);
+            relayoutBlocks(from, to);
+        }
+    }
+
+    // bracket depth of the edited blocks, then onwards until it settles
+    const QTextBlock first = document()->findBlockByNumber(firstNumber);
+    int depth = first.previous().isValid() ? endDepth(first.previous().userState()) : 0;
+    QTextBlock block = first;
+    while (block.isValid())
+    {
+        const int state   = bracketState(block.text(), depth);
+        const bool changed = state != block.userState();
+        block.setUserState(state);
+        depth = endDepth(state);
+        if (!changed && block.blockNumber() >= lastNumber)
+        {
+            break;
+        }
+        block = block.next();
+    }
+}
+
+void TextEditor::goToLine(int line)
+{
+    QTextBlock block = document()->findBlockByNumber(line - 1);
+    if (!block.isValid())
+    {
+        return;
+    }
+
+    // open the folds hiding the line, outermost first
+    if (!block.isVisible())
+    {
+        const QVector<FoldRangeTree::Range> folds = m_folds.overlapping(block.blockNumber(), block.blockNumber());
+        for (const FoldRangeTree::Range &range : folds)
+        {
+            if (range.start < block.blockNumber())
+            {
+                toggleFold(document()->findBlockByNumber(range.start));
+            }
+        }
+    }
+
+    setTextCursor(QTextCursor(block));
+    centerCursor();
+    setFocus();
+}
+
+void TextEditor::setIdentifierIndex(QSharedPointer<IdentifierIndex> index)
+{
+    m_identifierIndex = index;
+    indexDocument();
+}
+
+void TextEditor::indexDocument()
+{
+    // a streaming load is indexed once it is complete
+    if (m_identifierIndex.isNull() || m_loader != nullptr)
+    {
+        m_indexPending = false;
+        return;
+    }
+
+    // the whole text is tokenized on the index worker, edits wait for it
+    m_indexPending  = true;
+    m_indexRevision = document()->revision();
+    m_indexWatcher.setFuture(m_identifierIndex->tokenize(toPlainText()));
+}
+
+void TextEditor::documentIndexed()
+{
+    if (!m_indexPending)
+    {
+        return;
+    }
+    if (document()->revision() != m_indexRevision)
+    {
+        indexDocument();
+        return;
+    }
+
+    const IdentifierIndex::Snapshot snapshot = m_indexWatcher.result();
+    QTextBlock block = document()->begin();
+    for (const QVector<IdentifierIndex::WordHash> &hashes : snapshot.lines)
+    {
+        if (!block.isValid())
+        {
+            break;
+        }
+        BlockTokens *data = static_cast<BlockTokens *>(block.userData());
+        if (data == nullptr && !hashes.isEmpty())
+        {
+            data = new BlockTokens(m_tokenJournal);
+            block.setUserData(data);
+        }
+        if (data != nullptr)
+        {
+            m_tokenJournal->removed += data->hashes;
+            data->hashes = hashes;
+        }
+        block = block.next();
+    }
+    m_indexPending = false;
+
+    m_identifierIndex->update(m_tokenJournal->removed, QStringList());
+    m_tokenJournal->removed.clear();
+    m_identifierIndex->add(snapshot.counts);
+}
+
+void TextEditor::updateIdentifiers(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (m_identifierIndex.isNull() || m_editingCarets)
+    {
+        return;
+    }
+
+    // the words of deleted blocks always leave the index
+    QVector<IdentifierIndex::WordHash> removed = m_tokenJournal->removed;
+    QStringList added;
+    m_tokenJournal->removed.clear();
+    if (m_indexPending)
+    {
+        m_identifierIndex->update(removed, added);
+        return;
+    }
+
+    QTextBlock block = document()->findBlock(position);
+    QTextBlock last  = document()->findBlock(position + charsAdded);
+    if (!last.isValid())
+    {
+        last = document()->lastBlock();
+    }
+
+    // only the edited blocks are tokenized, the trie is updated on the
+    // index worker
+    while (block.isValid())
+    {
+        indexBlock(block, &removed, &added);
+        if (block == last)
+        {
+            break;
+        }
+        block = block.next();
+    }
+    m_identifierIndex->update(removed, added);
+}
+
+void TextEditor::indexBlock(QTextBlock block, QVector<IdentifierIndex::WordHash> *removed, QStringList *added)
+{
+    const QStringList words = IdentifierIndex::identifiers(block.text());
+    const QVector<IdentifierIndex::WordHash> hashes = IdentifierIndex::hashes(words);
+    BlockTokens *data = static_cast<BlockTokens *>(block.userData());
+    if (data == nullptr)
+    {
+        if (words.isEmpty())
+        {
+            return;
+        }
+        data = new BlockTokens(m_tokenJournal);
+        block.setUserData(data);
+    }
+    if (data->hashes == hashes)
+    {
+        return;
+    }
+    *removed += data->hashes;
+    *added   += words;
+    data->hashes = hashes;
+}
+
+QString TextEditor::completionPrefix() const
+{
+    const QTextCursor cursor = textCursor();
+    const QString text = cursor.block().text();
+    int start = cursor.positionInBlock();
+    while (start > 0 && IdentifierIndex::isIdentifierChar(text.at(start - 1)))
+    {
+        start--;
+    }
+    return text.mid(start, cursor.positionInBlock() - start);
+}
+
+void TextEditor::insertCompletion(const QString &completion)
+{
+    QTextCursor cursor = textCursor();
+    cursor.insertText(completion.mid(m_completer->completionPrefix().length()));
+    setTextCursor(cursor);
+}
+
+void TextEditor::setCarets(const QList<QTextCursor> &cursors)
+{
+    m_carets.clear();
+    m_carets.reserve(cursors.size());
+    for (const QTextCursor &cursor : cursors)
+    {
+        if (cursor.document() == document())
+        {
+            m_carets.append({cursor.anchor(), cursor.position()});
+        }
+    }
+
+    // kept sorted and disjoint, edits rely on it
+    std::sort(m_carets.begin(), m_carets.end(), [](const Caret &a, const Caret &b) { return a.start() < b.start(); });
+    int count = 0;
+    for (const Caret &caret : m_carets)
+    {
+        if (count == 0 || caret.start() >= m_carets[count - 1].end())
+        {
+            m_carets[count++] = caret;
+        }
+    }
+    m_carets.resize(count);
+
+    if (m_carets.size() < 2)
+    {
+        clearCarets();
+        return;
+    }
+
+    // drops the search highlight, whose cursor the document would track
+    highlightCurrentLine();
+
+    QTextCursor cursor(document());
+    cursor.setPosition(m_carets.last().anchor);
+    cursor.setPosition(m_carets.last().position, QTextCursor::KeepAnchor);
+    setTextCursor(cursor);
+    viewport()->update();
+}
+
+void TextEditor::clearCarets()
+{
+    if (m_carets.isEmpty())
+    {
+        return;
+    }
+    m_carets.clear();
+    viewport()->update();
+}
+
+bool TextEditor::caretKeyPressEvent(QKeyEvent *e)
+{
+    // word moves, word deletes and other modified keys end multi-cursor
+    // editing; shift extends the selections
+    if (e->modifiers() & (Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier))
+    {
+        return false;
+    }
+    const bool select = e->modifiers() & Qt::ShiftModifier;
+
+    switch (e->key())
+    {
+    case Qt::Key_Escape:
+        clearCarets();
+        return true;
+    case Qt::Key_Backspace:
+        editCarets(QString(), 1, 0);
+        return true;
+    case Qt::Key_Delete:
+        editCarets(QString(), 0, 1);
+        return true;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        editCarets(QString(QChar::ParagraphSeparator), 0, 0);
+        return true;
+    case Qt::Key_Tab:
+        editCarets(QString(QLatin1Char('\t')), 0, 0);
+        return true;
+    case Qt::Key_Left:
+        moveCarets(QTextCursor::Left, select);
+        return true;
+    case Qt::Key_Right:
+        moveCarets(QTextCursor::Right, select);
+        return true;
+    case Qt::Key_Home:
+        moveCarets(QTextCursor::StartOfBlock, select);
+        return true;
+    case Qt::Key_End:
+        moveCarets(QTextCursor::EndOfBlock, select);
+        return true;
+    default:
+        break;
+    }
+
+    const QString text = e->text();
+    if (text.isEmpty() || !text.at(0).isPrint())
+    {
+        return false;
+    }
+    editCarets(text, 0, 0);
+    return true;
+}
+
+void TextEditor::editCarets(const QString &text, int deleteBefore, int deleteAfter)
+{
+    const int count = m_carets.size();
+    const int documentEnd = document()->characterCount() - 1;
+    const int addedBlocks = text.count(QChar::ParagraphSeparator) + text.count('\n');
+    QVector<Caret> edits(count);
+    QVector<int> removedBlocks(count, 0);
+
+    // one edit block gives one undo step and one layout pass for all
+    // carets; editing back to front keeps the pending positions valid.
+    // The contentsChange of the block spans all carets, so folding and
+    // identifiers are updated per caret below instead
+    m_editingCarets = true;
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    for (int i = count - 1; i >= 0; i--)
+    {
+        int start = m_carets[i].start();
+        int end   = m_carets[i].end();
+        if (start == end)
+        {
+            start = qMax(i > 0 ? m_carets[i - 1].end() : 0, start - deleteBefore);
+            end   = qMin(i + 1 < count ? m_carets[i + 1].start() : documentEnd, end + deleteAfter);
+        }
+        edits[i] = {start, end};
+        if (start == end && text.isEmpty())
+        {
+            continue;
+        }
+        if (start != end)
+        {
+            removedBlocks[i] = document()->findBlock(end).blockNumber() - document()->findBlock(start).blockNumber();
+        }
+        cursor.setPosition(start);
+        cursor.setPosition(end, QTextCursor::KeepAnchor);
+        cursor.insertText(text);
+    }
+    cursor.endEditBlock();
+    m_foldBlockCount = blockCount();
+
+    // the new positions follow from the lengths, no cursor is tracked
+    QVector<IdentifierIndex::WordHash> removed = m_tokenJournal->removed;
+    QStringList added;
+    m_tokenJournal->removed.clear();
+    int shift = 0;
+    int merged = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const int start    = edits[i].start() + shift;
+        const int position = start + text.size();
+        shift += text.size() - (edits[i].end() - edits[i].start());
+        if (merged == 0 || m_carets[merged - 1].position != position)
+        {
+            m_carets[merged++] = {position, position};
+        }
+        if (edits[i].start() == edits[i].end() && text.isEmpty())
+        {
+            continue;
+        }
+
+        // folds ahead of this caret are already in the new numbering
+        const QTextBlock first = document()->findBlock(start);
+        const QTextBlock last  = document()->findBlock(position);
+        refoldBlocks(first.blockNumber(), last.blockNumber(), addedBlocks - removedBlocks[i]);
+        if (!m_identifierIndex.isNull() && !m_indexPending)
+        {
+            for (QTextBlock block = first; block.isValid(); block = block.next())
+            {
+                indexBlock(block, &removed, &added);
+                if (block == last)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    m_carets.resize(merged);
+    m_editingCarets = false;
+    if (!m_identifierIndex.isNull())
+    {
+        m_identifierIndex->update(removed, added);
+    }
+
+    cursor.setPosition(m_carets.last().position);
+    setTextCursor(cursor);
+    viewport()->update();
+}
+
+void TextEditor::moveCarets(QTextCursor::MoveOperation operation, bool select)
+{
+    const int documentEnd = document()->characterCount() - 1;
+    int merged = 0;
+    for (int i = 0; i < m_carets.size(); i++)
+    {
+        const Caret caret = m_carets[i];
+        const bool collapse = !select && caret.anchor != caret.position;
+        int position = caret.position;
+        switch (operation)
+        {
+        case QTextCursor::Left:
+            position = collapse ? caret.start() : qMax(0, position - 1);
+            break;
+        case QTextCursor::Right:
+            position = collapse ? caret.end() : qMin(documentEnd, position + 1);
+            break;
+        case QTextCursor::StartOfBlock:
+            position = document()->findBlock(position).position();
+            break;
+        case QTextCursor::EndOfBlock:
+        {
+            const QTextBlock block = document()->findBlock(position);
+            position = block.position() + block.length() - 1;
+            break;
+        }
+        default:
+            break;
+        }
+
+        const Caret moved = {select ? caret.anchor : position, position};
+        if (merged > 0)
+        {
+            // carets running into each other become one
+            Caret &previous = m_carets[merged - 1];
+            if (moved.start() < previous.end() || moved.position == previous.position)
+            {
+                const int start = qMin(previous.start(), moved.start());
+                const int end   = qMax(previous.end(), moved.end());
+                previous = moved.position < moved.anchor ? Caret{end, start} : Caret{start, end};
+                continue;
+            }
+        }
+        m_carets[merged++] = moved;
+    }
+    m_carets.resize(merged);
+
+    QTextCursor cursor = textCursor();
+    cursor.setPosition(m_carets.last().anchor);
+    cursor.setPosition(m_carets.last().position, QTextCursor::KeepAnchor);
+    setTextCursor(cursor);
+    viewport()->update();
+}
+
+void TextEditor::selectColumns(const QPoint &pos)
+{
+    const QTextCursor current = cursorForPosition(pos);
+    const int first = qMin(m_columnAnchorBlock, current.blockNumber());
+    const int last  = qMax(m_columnAnchorBlock, current.blockNumber());
+    const int left  = qMin(m_columnAnchorColumn, current.positionInBlock());
+    const int right = qMax(m_columnAnchorColumn, current.positionInBlock());
+
+    // one caret per line, short lines get an empty one at their end
+    m_carets.clear();
+    m_carets.reserve(last - first + 1);
+    QTextBlock block = document()->findBlockByNumber(first);
+    for (int number = first; block.isValid() && number <= last; number++, block = block.next())
+    {
+        if (!block.isVisible())
+        {
+            continue;
+        }
+        const int length = block.length() - 1;
+        m_carets.append({block.position() + qMin(left, length), block.position() + qMin(right, length)});
+    }
+
+    QTextCursor cursor(document());
+    cursor.setPosition(current.block().position() + qMin(right, current.block().length() - 1));
+    setTextCursor(cursor);
+    viewport()->update();
+}
+
+void TextEditor::mousePressEvent(QMouseEvent *e)
+{
+    if (e->button() == Qt::LeftButton && (e->modifiers() & Qt::AltModifier))
+    {
+        const QTextCursor cursor = cursorForPosition(e->pos());
+        m_columnSelecting    = true;
+        m_columnAnchorBlock  = cursor.blockNumber();
+        m_columnAnchorColumn = cursor.positionInBlock();
+        selectColumns(e->pos());
+        return;
+    }
+
+    clearCarets();
+    QPlainTextEdit::mousePressEvent(e);
+}
+
+void TextEditor::mouseMoveEvent(QMouseEvent *e)
+{
+    if (m_columnSelecting)
+    {
+        selectColumns(e->pos());
+        return;
+    }
+    QPlainTextEdit::mouseMoveEvent(e);
+}
+
+void TextEditor::mouseReleaseEvent(QMouseEvent *e)
+{
+    if (m_columnSelecting)
+    {
+        m_columnSelecting = false;
+        return;
+    }
+    QPlainTextEdit::mouseReleaseEvent(e);
+}
+
+void TextEditor::paintEvent(QPaintEvent *e)
+{
+    QPlainTextEdit::paintEvent(e);
+    if (m_carets.isEmpty())
+    {
+        return;
+    }
+
+    // only the carets inside the viewport are looked up and painted
+    const int first = firstVisibleBlock().position();
+    const QTextBlock bottom = cursorForPosition(viewport()->rect().bottomRight()).block();
+    const int last  = bottom.position() + bottom.length();
+    auto caret = std::lower_bound(m_carets.cbegin(), m_carets.cend(), first,
+                                  [](const Caret &c, int position) { return c.end() < position; });
+
+    QPainter painter(viewport());
+    QColor selectionColor = palette().highlight().color();
+    selectionColor.setAlpha(80);
+    QTextCursor cursor(document());
+    for (; caret != m_carets.cend() && caret->start() <= last; ++caret)
+    {
+        cursor.setPosition(caret->position);
+        if (!cursor.block().isVisible())
+        {
+            continue;
+        }
+        if (caret->anchor != caret->position)
+        {
+            cursor.setPosition(caret->start());
+            const QRect start = cursorRect(cursor);
+            cursor.setPosition(caret->end());
+            const QRect end = cursorRect(cursor);
+            if (start.top() == end.top())
+            {
+                painter.fillRect(QRect(start.topLeft(), QPoint(end.left(), end.bottom())), selectionColor);
+            }
+        }
+        cursor.setPosition(caret->position);
+        const QRect rect = cursorRect(cursor);
+        painter.fillRect(rect.x(), rect.y(), cursorWidth(), rect.height(), palette().text());
+    }
+}
+
+void TextEditor::keyPressEvent(QKeyEvent *e)
+{
+    if (!m_carets.isEmpty())
+    {
+        if (caretKeyPressEvent(e))
+        {
+            return;
+        }
+        clearCarets();
+    }
+
+    if (m_completer->popup()->isVisible())
+    {
+        // the popup handles these itself
+        switch (e->key())
+        {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Escape:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+            e->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
+    const bool shortcut = (e->modifiers() & Qt::ControlModifier) && e->key() == Qt::Key_Space;
+    if (!shortcut)
+    {
+        QPlainTextEdit::keyPressEvent(e);
+    }
+
+    const QString prefix = completionPrefix();
+    const bool typing = !e->text().isEmpty()
+                        && IdentifierIndex::isIdentifierChar(e->text().at(e->text().size() - 1))
+                        && !(e->modifiers() & (Qt::ControlModifier | Qt::AltModifier));
+    if (m_identifierIndex.isNull() || prefix.isEmpty() || (!shortcut && (!typing || prefix.length() < MinCompletionPrefix)))
+    {
+        m_completer->popup()->hide();
+        return;
+    }
+
+    const QStringList words = m_identifierIndex->complete(prefix, MaxCompletions);
+    if (words.isEmpty())
+    {
+        m_completer->popup()->hide();
+        return;
+    }
+
+    m_completionModel->setStringList(words);
+    m_completer->setCompletionPrefix(prefix);
+    m_completer->popup()->setCurrentIndex(m_completer->completionModel()->index(0, 0));
+
+    QRect rect = cursorRect();
+    rect.setWidth(m_completer->popup()->sizeHintForColumn(0) + m_completer->popup()->verticalScrollBar()->sizeHint().width());
+    m_completer->complete(rect);
+}
+
 void TextEditor::load(QString fileName)
 {
     if(fileName == "") {
         m_fileName = tr("newfile.txt");
-        setFont(QFont("Monospace", 10));
         document()->setModified(false);
         emit documentChanged();
         return;
@@ -92,9 +1160,21 @@ void TextEditor::load(QString fileName)
         return;
     }
 
+    const CompressedFile::Format format = CompressedFile::format(fileName);
+    if (format != CompressedFile::None) {
+        file.close();
+        setFirstSave(true);
+        loadCompressed(fileName, format);
+        return;
+    }
+
+    m_compression = CompressedFile::None;
     QString text = file.readAll();
     file.close();
+    clearFolds();
+    m_indexPending = true;
     setPlainText(text);
+    indexDocument();
     setFirstSave(true);
     document()->setModified(false);
     emit documentChanged();
@@ -102,6 +1182,11 @@ void TextEditor::load(QString fileName)
 
 void TextEditor::save()
 {
+    if (m_loader != nullptr) {
+        QMessageBox::warning(this, tr("Warning"), tr("Cannot save while the file is still loading."));
+        return;
+    }
+
     if (!firstSave()) {
         saveAs();
         return;
@@ -113,7 +1198,12 @@ void TextEditor::save()
         return;
     }
     else {
-        file.write(toPlainText().toUtf8());
+        QString errorString;
+        if (!CompressedFile::write(m_compression, toPlainText().toUtf8(), &file, &errorString)) {
+            QMessageBox::critical(this, tr("Critical"), tr("Cannot write file: ") + errorString);
+            file.close();
+            return;
+        }
         file.close();
         document()->setModified(false);
         emit documentChanged();
@@ -122,6 +1212,11 @@ void TextEditor::save()
 
 void TextEditor::saveAs()
 {
+    if (m_loader != nullptr) {
+        QMessageBox::warning(this, tr("Warning"), tr("Cannot save while the file is still loading."));
+        return;
+    }
+
     saveFileContent(toPlainText().toUtf8(), fileName());
 }
 
@@ -134,8 +1229,14 @@ void TextEditor::saveFileContent(const QByteArray &fileContent, const QString &f
     auto fileSelected = [=](const QString &fileName) {
         if (!fileName.isNull()) {
             QFile selectedFile(fileName);
+            QString errorString;
             if (selectedFile.open(QIODevice::WriteOnly)) {
-                selectedFile.write(fileContent);
+                // the suffix picks the compression of the new file
+                if (!CompressedFile::write(CompressedFile::formatForName(fileName), fileContent, &selectedFile, &errorString)) {
+                    QMessageBox::critical(this, tr("Critical"), tr("Cannot write file: ") + errorString);
+                    selectedFile.close();
+                    return;
+                }
                 selectedFile.close();
                 setFirstSave(true);
                 m_fileName = fileName;
@@ -160,12 +1261,101 @@ void TextEditor::reload()
     if (!firstSave()) {
         saveAs();
     }
+
+    const CompressedFile::Format format = CompressedFile::format(m_fileName);
+    if (format != CompressedFile::None) {
+        loadCompressed(m_fileName, format);
+        return;
+    }
+
+    m_compression = CompressedFile::None;
     QFile file(m_fileName);
     file.open(QIODevice::ReadOnly | QFile::Text);
     QString text = file.readAll();
     file.close();
+    clearFolds();
+    m_indexPending = true;
     setPlainText(text);
+    indexDocument();
+    document()->setModified(false);
+    emit documentChanged();
+}
+
+void TextEditor::loadCompressed(const QString &fileName, CompressedFile::Format format)
+{
+    if (!CompressedFile::isSupported(format)) {
+        QMessageBox::critical(this, tr("Critical"), tr("Cannot read file: ") + tr("compression format not supported by this build"));
+        return;
+    }
+
+    delete m_loader;
+    m_compression = format;
+
+    // the document fills up while the pipeline runs, nothing to undo
+    document()->setUndoRedoEnabled(false);
+    clearFolds();
+    m_indexPending = true;
+    clear();
+    document()->setModified(false);
+    setReadOnly(true);
+
+    m_loader = new DecompressPipeline(fileName, format, this);
+    connect(m_loader, &DecompressPipeline::textAvailable, this, &TextEditor::appendDecodedText);
+    connect(m_loader, &DecompressPipeline::finished, this, &TextEditor::appendDecodedText);
+    connect(m_loader, &DecompressPipeline::failed, this, [=](const QString &errorString) {
+        QMessageBox::critical(this, tr("Critical"), tr("Cannot read file: ") + errorString);
+        appendDecodedText();
+    });
+    m_loader->start();
+}
+
+void TextEditor::appendDecodedText()
+{
+    if (m_loader == nullptr)
+    {
+        return;
+    }
+
+    // insert for one frame at most, then give the event loop a turn
+    QElapsedTimer timer;
+    timer.start();
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+
+    QString text;
+    bool pending = false;
+    while (m_loader->takeText(&text))
+    {
+        cursor.insertText(text);
+        if (timer.elapsed() >= 16)
+        {
+            pending = true;
+            break;
+        }
+    }
+    // the file is not changed by loading it, closing meanwhile asks nothing
     document()->setModified(false);
+
+    if (pending)
+    {
+        QTimer::singleShot(0, this, &TextEditor::appendDecodedText);
+        return;
+    }
+    if (!m_loader->atEnd())
+    {
+        return;
+    }
+
+    if (m_loader->hasFailed())
+    {
+        // the partial text must not replace the file, save goes through save as
+        setFirstSave(false);
+    }
+    m_loader->deleteLater();
+    m_loader = nullptr;
+    setReadOnly(false);
+    document()->setUndoRedoEnabled(true);
+    indexDocument();
     emit documentChanged();
 }
 
@@ -198,6 +1388,17 @@ void TextEditor::resizeEvent(QResizeEvent *e)
     m_lineNumberWidget->setGeometry(0, 0, getLineNumberWidth(), contentsRect().height());
 }
 
+void TextEditor::changeEvent(QEvent *e)
+{
+    QPlainTextEdit::changeEvent(e);
+    if (e->type() == QEvent::FontChange)
+    {
+        // the gutter is sized by the digit width of the font
+        updateLineNumberMargin();
+        m_lineNumberWidget->setGeometry(0, 0, getLineNumberWidth(), contentsRect().height());
+    }
+}
+
 void TextEditor::highlightCurrentLine()
 {
     QList<QTextEdit::ExtraSelection> extraSelections;
@@ -220,7 +1421,7 @@ void TextEditor::updateLineNumberMargin()
 int TextEditor::getLineNumberWidth()
 {
     int defalut = 22;
-    defalut     = 4 + QString::number(blockCount()).length() * fontMetrics().horizontalAdvance('0');
+    defalut     = 4 + QString::number(blockCount()).length() * fontMetrics().horizontalAdvance('0') + foldMarkerWidth();
     defalut     = qMax(22, defalut);
 
     return defalut;
@@ -236,3 +1437,8 @@ void LineNumberWidget::paintEvent(QPaintEvent *event)
 {
     m_editor->lineNumberPaintEvent(event);
 }
+
+void LineNumberWidget::mousePressEvent(QMouseEvent *event)
+{
+    m_editor->lineNumberMousePressEvent(event);
+}
@@ -6,16 +6,33 @@
 
 #include <QPlainTextEdit>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QTextBlock>
+
+#include "compressedfile.h"
+#include "foldrangetree.h"
+#include "identifierindex.h"
+
+class QCompleter;
+class QStringListModel;
+struct TokenJournal;
 
 class LineNumberWidget;
 class TextEditor : public QPlainTextEdit
 {
     Q_OBJECT
 public:
-    TextEditor(QWidget *parent, const QString& fileName);
+    TextEditor(QWidget *parent, const QString& fileName, const QFont &font = QFont("Monospace", 10));
     ~TextEditor();
 
     void lineNumberPaintEvent(QPaintEvent *e);
+    void lineNumberMousePressEvent(QMouseEvent *e);
+    void toggleFold(const QTextBlock &block);
+    void goToLine(int line);
+    void setIdentifierIndex(QSharedPointer<IdentifierIndex> index);
+    void setCarets(const QList<QTextCursor> &cursors);
+    void clearCarets();
 
     void load(QString fileName);
     void reload();
@@ -39,20 +56,73 @@ public slots:
 
 protected:
     void resizeEvent(QResizeEvent *e) override;
+    void changeEvent(QEvent *e) override;
+    void keyPressEvent(QKeyEvent *e) override;
+    void paintEvent(QPaintEvent *e) override;
+    void mousePressEvent(QMouseEvent *e) override;
+    void mouseMoveEvent(QMouseEvent *e) override;
+    void mouseReleaseEvent(QMouseEvent *e) override;
 
 private slots:
     void highlightCurrentLine();
     void updateLineNumberMargin();
+    void updateFolding(int position, int charsRemoved, int charsAdded);
+    void appendDecodedText();
+    void updateIdentifiers(int position, int charsRemoved, int charsAdded);
+    void documentIndexed();
+    void insertCompletion(const QString &completion);
     int getLineNumberWidth();
 
 private:
+    struct Caret
+    {
+        int anchor;
+        int position;
+
+        int start() const { return qMin(anchor, position); }
+        int end() const { return qMax(anchor, position); }
+    };
+
     LineNumberWidget *m_lineNumberWidget;
     QString m_fileName;
     bool m_firstSave;
+    FoldRangeTree m_folds;
+    int m_foldBlockCount;
+    bool m_updatingFolds;
+    CompressedFile::Format m_compression;
+    DecompressPipeline *m_loader;
+    QSharedPointer<IdentifierIndex> m_identifierIndex;
+    QSharedPointer<TokenJournal> m_tokenJournal;
+    QFutureWatcher<IdentifierIndex::Snapshot> m_indexWatcher;
+    bool m_indexPending;
+    int m_indexRevision;
+    QCompleter *m_completer;
+    QStringListModel *m_completionModel;
+    QVector<Caret> m_carets;
+    bool m_editingCarets;
+    bool m_columnSelecting;
+    int m_columnAnchorBlock;
+    int m_columnAnchorColumn;
 
     void setFirstSave(bool state) { m_firstSave = state; }
     bool firstSave() const { return m_firstSave; }
     void saveFileContent(const QByteArray &fileContent, const QString &fileNameHint);
+    void loadCompressed(const QString &fileName, CompressedFile::Format format);
+
+    int foldMarkerWidth() const { return fontMetrics().height(); }
+    bool isFoldable(const QTextBlock &block) const;
+    bool foldRange(const QTextBlock &block, int *end) const;
+    void showBlocks(int first, int last);
+    void relayoutBlocks(int first, int last);
+    void refoldBlocks(int firstNumber, int lastNumber, int delta);
+    void clearFolds();
+    void indexBlock(QTextBlock block, QVector<IdentifierIndex::WordHash> *removed, QStringList *added);
+    void indexDocument();
+    QString completionPrefix() const;
+    bool caretKeyPressEvent(QKeyEvent *e);
+    void editCarets(const QString &text, int deleteBefore, int deleteAfter);
+    void moveCarets(QTextCursor::MoveOperation operation, bool select);
+    void selectColumns(const QPoint &pos);
 };
 
 class LineNumberWidget : public QWidget
@@ -62,6 +132,7 @@ public:
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
 
 private:
     TextEditor *m_editor;